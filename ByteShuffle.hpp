@@ -0,0 +1,279 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#define BYTE_SHUFFLE_AVX2 1
+#elif defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define BYTE_SHUFFLE_SSE2 1
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#include <arm_neon.h>
+#define BYTE_SHUFFLE_NEON 1
+#endif
+
+//==========================================================================
+// Byte shuffling of arrays of trivially copyable values, as a filter ahead of
+// compression. The bytes are transposed, so that byte 0 of every element is
+// followed by byte 1 of every element and so on. Numeric arrays whose values
+// are close to each other then become long runs of similar bytes, which a
+// generic compressor handles far better than the interleaved form:
+// a_Serialiser << AsShuffled( Samples );
+// a_Deserialiser >> AsShuffled( Samples );
+// a_Sizer + AsShuffled( Samples );
+//
+// The wrapper shuffles blocks of at most BlockSize bytes on the stack as they
+// stream through the archive, so a compressing segment writer behind the
+// Serialiser sees the shuffled form. The kernels can also be run directly over
+// a buffer before handing it to a compressor. Elements of 2, 4 and 8 bytes are
+// transposed with AVX2, SSE2 or NEON byte interleaves, other sizes by a scalar loop.
+//==========================================================================
+namespace ByteShuffle
+{
+// Bytes shuffled per block by the archive wrapper.
+static constexpr size_t BlockSize = 16u * 1024u;
+
+#if defined( BYTE_SHUFFLE_AVX2 ) || defined( BYTE_SHUFFLE_SSE2 ) || defined( BYTE_SHUFFLE_NEON )
+// Byte interleaves over the widest available registers. Registers wider than 16 bytes interleave within each 16 byte
+// lane, so they transpose independent groups of 16 elements side by side, loaded from and stored to split addresses.
+struct Lanes
+{
+#if defined( BYTE_SHUFFLE_AVX2 )
+	using Register = __m256i;
+	static constexpr size_t Elements = 32u;
+
+	static inline Register Load( const byte_t* a_Source ) { return _mm256_loadu_si256( reinterpret_cast< const __m256i* >( a_Source ) ); }
+	static inline void Store( byte_t* o_Destination, Register a_Value ) { _mm256_storeu_si256( reinterpret_cast< __m256i* >( o_Destination ), a_Value ); }
+	static inline Register Low( Register a_First, Register a_Second ) { return _mm256_unpacklo_epi8( a_First, a_Second ); }
+	static inline Register High( Register a_First, Register a_Second ) { return _mm256_unpackhi_epi8( a_First, a_Second ); }
+
+	static inline Register LoadSplit( const byte_t* a_Source, size_t a_Stride )
+	{
+		const __m128i First = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_Source ) );
+		const __m128i Second = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_Source + a_Stride ) );
+		return _mm256_inserti128_si256( _mm256_castsi128_si256( First ), Second, 1 );
+	}
+
+	static inline void StoreSplit( byte_t* o_Destination, size_t a_Stride, Register a_Value )
+	{
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( o_Destination ), _mm256_castsi256_si128( a_Value ) );
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( o_Destination + a_Stride ), _mm256_extracti128_si256( a_Value, 1 ) );
+	}
+#elif defined( BYTE_SHUFFLE_SSE2 )
+	using Register = __m128i;
+	static constexpr size_t Elements = 16u;
+
+	static inline Register Load( const byte_t* a_Source ) { return _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_Source ) ); }
+	static inline void Store( byte_t* o_Destination, Register a_Value ) { _mm_storeu_si128( reinterpret_cast< __m128i* >( o_Destination ), a_Value ); }
+	static inline Register Low( Register a_First, Register a_Second ) { return _mm_unpacklo_epi8( a_First, a_Second ); }
+	static inline Register High( Register a_First, Register a_Second ) { return _mm_unpackhi_epi8( a_First, a_Second ); }
+	static inline Register LoadSplit( const byte_t* a_Source, size_t ) { return Load( a_Source ); }
+	static inline void StoreSplit( byte_t* o_Destination, size_t, Register a_Value ) { Store( o_Destination, a_Value ); }
+#else
+	using Register = uint8x16_t;
+	static constexpr size_t Elements = 16u;
+
+	static inline Register Load( const byte_t* a_Source ) { return vld1q_u8( reinterpret_cast< const uint8_t* >( a_Source ) ); }
+	static inline void Store( byte_t* o_Destination, Register a_Value ) { vst1q_u8( reinterpret_cast< uint8_t* >( o_Destination ), a_Value ); }
+	static inline Register Low( Register a_First, Register a_Second ) { return vzip1q_u8( a_First, a_Second ); }
+	static inline Register High( Register a_First, Register a_Second ) { return vzip2q_u8( a_First, a_Second ); }
+	static inline Register LoadSplit( const byte_t* a_Source, size_t ) { return Load( a_Source ); }
+	static inline void StoreSplit( byte_t* o_Destination, size_t, Register a_Value ) { Store( o_Destination, a_Value ); }
+#endif
+
+	// Interleave the first half of the registers with the second half, byte by byte. On the 16 bytes of Size registers,
+	// each pass rotates the bits of every byte's index left by one, so repeated passes transpose Size x 16 byte matrices.
+	template < size_t Size >
+	static inline void Interleave( Register ( &io_Registers )[ Size ] )
+	{
+		Register Interleaved[ Size ];
+
+		for ( size_t i = 0; i < Size / 2u; ++i )
+		{
+			Interleaved[ i * 2u ] = Low( io_Registers[ i ], io_Registers[ i + Size / 2u ] );
+			Interleaved[ i * 2u + 1u ] = High( io_Registers[ i ], io_Registers[ i + Size / 2u ] );
+		}
+
+		for ( size_t i = 0; i < Size; ++i )
+		{
+			io_Registers[ i ] = Interleaved[ i ];
+		}
+	}
+};
+#endif
+
+// Transpose the bytes of a_Count elements of a_Size bytes into a_Size planes of a_Count bytes.
+inline void Shuffle( const void* a_Source, size_t a_Count, size_t a_Size, void* o_Destination )
+{
+	auto* Source = static_cast< const byte_t* >( a_Source );
+	auto* Destination = static_cast< byte_t* >( o_Destination );
+	size_t i = 0;
+
+#if defined( BYTE_SHUFFLE_AVX2 ) || defined( BYTE_SHUFFLE_SSE2 ) || defined( BYTE_SHUFFLE_NEON )
+	const auto Transpose = [ & ]< size_t Size >()
+	{
+		for ( ; i + Lanes::Elements <= a_Count; i += Lanes::Elements )
+		{
+			Lanes::Register Registers[ Size ];
+
+			for ( size_t r = 0; r < Size; ++r )
+			{
+				Registers[ r ] = Lanes::LoadSplit( Source + i * Size + r * 16u, Size * 16u );
+			}
+
+			// Element index bits move above the byte index bits in four passes.
+			for ( size_t Pass = 0; Pass < 4u; ++Pass )
+			{
+				Lanes::Interleave( Registers );
+			}
+
+			for ( size_t r = 0; r < Size; ++r )
+			{
+				Lanes::Store( Destination + r * a_Count + i, Registers[ r ] );
+			}
+		}
+	};
+
+	switch ( a_Size )
+	{
+	case 2u: Transpose.template operator()< 2u >(); break;
+	case 4u: Transpose.template operator()< 4u >(); break;
+	case 8u: Transpose.template operator()< 8u >(); break;
+	}
+#endif
+
+	if ( a_Size == 1u )
+	{
+		memcpy( Destination, Source, a_Count );
+		return;
+	}
+
+	for ( ; i < a_Count; ++i )
+	{
+		for ( size_t b = 0; b < a_Size; ++b )
+		{
+			Destination[ b * a_Count + i ] = Source[ i * a_Size + b ];
+		}
+	}
+}
+
+// Reverse Shuffle, gathering a_Size planes of a_Count bytes back into a_Count elements of a_Size bytes.
+inline void Unshuffle( const void* a_Source, size_t a_Count, size_t a_Size, void* o_Destination )
+{
+	auto* Source = static_cast< const byte_t* >( a_Source );
+	auto* Destination = static_cast< byte_t* >( o_Destination );
+	size_t i = 0;
+
+#if defined( BYTE_SHUFFLE_AVX2 ) || defined( BYTE_SHUFFLE_SSE2 ) || defined( BYTE_SHUFFLE_NEON )
+	const auto Transpose = [ & ]< size_t Size, size_t Passes >()
+	{
+		for ( ; i + Lanes::Elements <= a_Count; i += Lanes::Elements )
+		{
+			Lanes::Register Registers[ Size ];
+
+			for ( size_t r = 0; r < Size; ++r )
+			{
+				Registers[ r ] = Lanes::Load( Source + r * a_Count + i );
+			}
+
+			// Byte index bits move back below the element index bits in log2( Size ) passes.
+			for ( size_t Pass = 0; Pass < Passes; ++Pass )
+			{
+				Lanes::Interleave( Registers );
+			}
+
+			for ( size_t r = 0; r < Size; ++r )
+			{
+				Lanes::StoreSplit( Destination + i * Size + r * 16u, Size * 16u, Registers[ r ] );
+			}
+		}
+	};
+
+	switch ( a_Size )
+	{
+	case 2u: Transpose.template operator()< 2u, 1u >(); break;
+	case 4u: Transpose.template operator()< 4u, 2u >(); break;
+	case 8u: Transpose.template operator()< 8u, 3u >(); break;
+	}
+#endif
+
+	if ( a_Size == 1u )
+	{
+		memcpy( Destination, Source, a_Count );
+		return;
+	}
+
+	for ( ; i < a_Count; ++i )
+	{
+		for ( size_t b = 0; b < a_Size; ++b )
+		{
+			Destination[ i * a_Size + b ] = Source[ b * a_Count + i ];
+		}
+	}
+}
+}
+
+// Byte shuffled encoding of the elements of a contiguous container of trivially copyable values, such as a std::vector.
+template < typename T >
+class Shuffled
+{
+public:
+
+	using Value = std::remove_cvref_t< decltype( *std::declval< T& >().data() ) >;
+
+	static_assert( std::is_trivially_copyable_v< Value >, "Only trivially copyable elements are byte shuffled." );
+
+	// Elements shuffled per block, never less than one.
+	static constexpr size_t BlockCount = sizeof( Value ) < ByteShuffle::BlockSize ? ByteShuffle::BlockSize / sizeof( Value ) : 1u;
+
+	Shuffled( T& a_Value )
+		: m_Value( a_Value )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		const size_t Size = m_Value.size();
+		a_Serialiser.SerialiseAsMemory( &Size, sizeof( Size ) );
+
+		byte_t Block[ BlockCount * sizeof( Value ) ];
+
+		for ( size_t i = 0; i < Size; i += BlockCount )
+		{
+			const size_t Count = Size - i < BlockCount ? Size - i : BlockCount;
+			ByteShuffle::Shuffle( m_Value.data() + i, Count, sizeof( Value ), Block );
+			a_Serialiser.SerialiseAsMemory( Block, Count * sizeof( Value ) );
+		}
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		size_t Size;
+		a_Deserialiser.ReadSize( Size );
+		m_Value.resize( Size );
+
+		byte_t Block[ BlockCount * sizeof( Value ) ];
+
+		for ( size_t i = 0; i < Size; i += BlockCount )
+		{
+			const size_t Count = Size - i < BlockCount ? Size - i : BlockCount;
+			a_Deserialiser.DeserialiseAsMemory( Block, Count * sizeof( Value ) );
+			ByteShuffle::Unshuffle( Block, Count, sizeof( Value ), m_Value.data() + i );
+		}
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		a_Sizer.AddSizeOfMemory( sizeof( size_t ) + sizeof( Value ) * m_Value.size() );
+	}
+
+private:
+
+	T& m_Value;
+};
+
+template < typename T >
+inline Shuffled< T > AsShuffled( T& a_Value ) { return { a_Value }; }
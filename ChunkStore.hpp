@@ -0,0 +1,454 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/FastHash.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+//==========================================================================
+// Incremental storage of successive snapshots. The serialised stream is cut
+// into chunks at content defined boundaries, so that an edit only changes the
+// chunks around it and the rest of the stream cuts exactly as before. Chunks
+// are stored once each in a content addressed ChunkStore, and a snapshot is
+// kept as a manifest of the chunks it is made of:
+// ChunkStore Store( "Snapshots" );
+//
+// ChunkWriter Writer( Store );
+// Serialiser serialiser( Writer );
+// serialiser << World;
+// serialiser.Flush();
+// Store.PutManifest( "Frame1000", Writer.GetManifest() );
+//
+// ChunkManifest Manifest;
+// Store.GetManifest( "Frame1000", Manifest );
+// ChunkReader Reader( Store, Manifest );
+// Deserialiser deserialiser( Reader );
+// deserialiser >> World;
+//
+// Boundaries are found with a gear hash, FastCDC style: no cut before the
+// minimum size, a stricter mask up to the average size and a looser one
+// after it, and a forced cut at the maximum size. Chunks are identified by a
+// 128 bit FastHash, which is verified as they are read back.
+//==========================================================================
+
+// Finds content defined chunk boundaries.
+class Chunker
+{
+public:
+
+	static constexpr size_t DefaultMinSize = 2u * 1024u;
+	static constexpr size_t DefaultAverageSize = 8u * 1024u;
+	static constexpr size_t DefaultMaxSize = 64u * 1024u;
+
+	// The gear hash at a position depends only on this many bytes before it.
+	static constexpr size_t Window = 64u;
+
+	// The average size is rounded down to a power of two.
+	Chunker( size_t a_MinSize = DefaultMinSize, size_t a_AverageSize = DefaultAverageSize, size_t a_MaxSize = DefaultMaxSize )
+		: m_MinSize( a_MinSize )
+		, m_AverageSize( a_AverageSize )
+		, m_MaxSize( a_MaxSize > a_MinSize ? a_MaxSize : a_MinSize + 1u )
+	{
+		unsigned Bits = 2u;
+
+		while ( ( size_t( 2u ) << Bits ) <= a_AverageSize && Bits < 62u )
+		{
+			++Bits;
+		}
+
+		// Test the high bits of the hash, which depend on the whole window; the low bits only see the last few bytes.
+		m_StrictMask = ~uint64_t( 0u ) << ( 64u - ( Bits + 1u ) );
+		m_LooseMask = ~uint64_t( 0u ) << ( 64u - ( Bits - 1u ) );
+	}
+
+	// Get the length of the first chunk of the data, or zero if the data ends before its boundary.
+	size_t FindBoundary( const byte_t* a_Data, size_t a_Size ) const
+	{
+		if ( a_Size <= m_MinSize )
+		{
+			return 0u;
+		}
+
+		const auto* Data = reinterpret_cast< const uint8_t* >( a_Data );
+		const size_t Normal = a_Size < m_AverageSize ? a_Size : m_AverageSize;
+		const size_t End = a_Size < m_MaxSize ? a_Size : m_MaxSize;
+
+		// Warm the hash up over the window before the minimum, so that the first boundary tested does not depend on where the chunk began.
+		size_t i = m_MinSize > Window ? m_MinSize - Window : 0u;
+		uint64_t Hash = 0u;
+
+		for ( ; i < m_MinSize; ++i )
+		{
+			Hash = ( Hash << 1u ) + GetGear( Data[ i ] );
+		}
+
+		for ( ; i < Normal; ++i )
+		{
+			Hash = ( Hash << 1u ) + GetGear( Data[ i ] );
+
+			if ( !( Hash & m_StrictMask ) )
+			{
+				return i + 1u;
+			}
+		}
+
+		for ( ; i < End; ++i )
+		{
+			Hash = ( Hash << 1u ) + GetGear( Data[ i ] );
+
+			if ( !( Hash & m_LooseMask ) )
+			{
+				return i + 1u;
+			}
+		}
+
+		return a_Size >= m_MaxSize ? m_MaxSize : 0u;
+	}
+
+	inline size_t GetMaxSize() const { return m_MaxSize; }
+
+private:
+
+	// Random values for each byte, from a fixed seed so that boundaries are stable across runs and builds.
+	static uint64_t GetGear( uint8_t a_Byte )
+	{
+		static constexpr std::array< uint64_t, 256 > Gears = []()
+		{
+			std::array< uint64_t, 256 > Values = {};
+			uint64_t State = 0x2545F4914F6CDD1Dull;
+
+			for ( uint64_t& Value : Values )
+			{
+				// SplitMix64.
+				uint64_t Mixed = ( State += 0x9E3779B97F4A7C15ull );
+				Mixed = ( Mixed ^ ( Mixed >> 30u ) ) * 0xBF58476D1CE4E5B9ull;
+				Mixed = ( Mixed ^ ( Mixed >> 27u ) ) * 0x94D049BB133111EBull;
+				Value = Mixed ^ ( Mixed >> 31u );
+			}
+
+			return Values;
+		}();
+
+		return Gears[ a_Byte ];
+	}
+
+	size_t   m_MinSize;
+	size_t   m_AverageSize;
+	size_t   m_MaxSize;
+	uint64_t m_StrictMask;
+	uint64_t m_LooseMask;
+};
+
+// Identifies a chunk by the hash of its content.
+struct ChunkId
+{
+	uint64_t Low;
+	uint64_t High;
+
+	static ChunkId Of( std::span< const byte_t > a_Data )
+	{
+		const FastHash::Digest128 Digest = FastHash::Hash128( a_Data.data(), a_Data.size() );
+		return { Digest.Low, Digest.High };
+	}
+
+	std::string ToString() const
+	{
+		static constexpr char Digits[] = "0123456789abcdef";
+		std::string Hex( 32u, '0' );
+
+		for ( size_t i = 0; i < 16u; ++i )
+		{
+			Hex[ 15u - i ] = Digits[ ( High >> ( i * 4u ) ) & 15u ];
+			Hex[ 31u - i ] = Digits[ ( Low >> ( i * 4u ) ) & 15u ];
+		}
+
+		return Hex;
+	}
+
+	friend bool operator==( const ChunkId&, const ChunkId& ) = default;
+};
+
+struct ChunkReference
+{
+	ChunkId  Id;
+	uint64_t Size;
+};
+
+// The chunks of a snapshot, in order.
+struct ChunkManifest
+{
+	std::vector< ChunkReference > Chunks;
+
+	uint64_t GetSize() const
+	{
+		uint64_t Size = 0u;
+
+		for ( const ChunkReference& Chunk : Chunks )
+		{
+			Size += Chunk.Size;
+		}
+
+		return Size;
+	}
+};
+
+// A content addressed store of chunks and named manifests, in a local directory. Files are written under a unique temporary
+// name and renamed into place once closed, so a store interrupted mid-write never holds a partial chunk or manifest under its
+// real name. A temporary whose write fails is removed.
+class ChunkStore
+{
+public:
+
+	ChunkStore( std::filesystem::path a_Root )
+		: m_Root( std::move( a_Root ) )
+	{}
+
+	inline const std::filesystem::path& GetRoot() const { return m_Root; }
+
+	// Get the path of a chunk, fanned out over directories by the first byte of its ID.
+	std::filesystem::path GetChunkPath( const ChunkId& a_Id ) const
+	{
+		const std::string Name = a_Id.ToString();
+		return m_Root / "chunks" / Name.substr( 0u, 2u ) / Name;
+	}
+
+	std::filesystem::path GetManifestPath( const std::string& a_Name ) const
+	{
+		return m_Root / "manifests" / a_Name;
+	}
+
+	bool Contains( const ChunkId& a_Id ) const
+	{
+		std::error_code Error;
+		return std::filesystem::exists( GetChunkPath( a_Id ), Error );
+	}
+
+	// Store a chunk unless the store already has it. Returns false if it could not be written.
+	bool Put( const ChunkId& a_Id, std::span< const byte_t > a_Data )
+	{
+		return Contains( a_Id ) || WriteFile( GetChunkPath( a_Id ), a_Data.data(), a_Data.size() );
+	}
+
+	// Read a chunk. Returns false if it is missing, or if its content does not match its ID.
+	bool Get( const ChunkId& a_Id, std::vector< byte_t >& o_Data ) const
+	{
+		return ReadFile( GetChunkPath( a_Id ), o_Data ) && ChunkId::Of( o_Data ) == a_Id;
+	}
+
+	bool PutManifest( const std::string& a_Name, const ChunkManifest& a_Manifest )
+	{
+		return WriteFile( GetManifestPath( a_Name ), a_Manifest.Chunks.data(), a_Manifest.Chunks.size() * sizeof( ChunkReference ) );
+	}
+
+	bool GetManifest( const std::string& a_Name, ChunkManifest& o_Manifest ) const
+	{
+		std::vector< byte_t > Data;
+
+		if ( !ReadFile( GetManifestPath( a_Name ), Data ) || Data.size() % sizeof( ChunkReference ) )
+		{
+			return false;
+		}
+
+		o_Manifest.Chunks.resize( Data.size() / sizeof( ChunkReference ) );
+
+		if ( !Data.empty() )
+		{
+			memcpy( o_Manifest.Chunks.data(), Data.data(), Data.size() );
+		}
+
+		return true;
+	}
+
+private:
+
+	static bool WriteFile( const std::filesystem::path& a_Path, const void* a_Data, size_t a_Size )
+	{
+		std::error_code Error;
+		std::filesystem::create_directories( a_Path.parent_path(), Error );
+
+		// Name the temporary uniquely, so that writers of the same file, in this process or another, never share one.
+		static std::atomic< uint64_t > Counter = ( static_cast< uint64_t >( std::random_device{}() ) << 32u ) ^ std::random_device{}();
+		char Suffix[ 24 ];
+		snprintf( Suffix, sizeof( Suffix ), ".%016llx.tmp", static_cast< unsigned long long >( Counter.fetch_add( 1u, std::memory_order_relaxed ) ) );
+
+		std::filesystem::path Temporary = a_Path;
+		Temporary += Suffix;
+
+		std::ofstream File( Temporary, std::ios::binary | std::ios::trunc );
+		File.write( static_cast< const char* >( a_Data ), static_cast< std::streamsize >( a_Size ) );
+		File.close();
+
+		if ( File )
+		{
+			std::filesystem::rename( Temporary, a_Path, Error );
+
+			if ( !Error )
+			{
+				return true;
+			}
+		}
+
+		std::filesystem::remove( Temporary, Error );
+		return false;
+	}
+
+	static bool ReadFile( const std::filesystem::path& a_Path, std::vector< byte_t >& o_Data )
+	{
+		std::ifstream File( a_Path, std::ios::binary | std::ios::ate );
+
+		if ( !File )
+		{
+			return false;
+		}
+
+		o_Data.resize( static_cast< size_t >( File.tellg() ) );
+		File.seekg( 0 );
+		return static_cast< bool >( File.read( reinterpret_cast< char* >( o_Data.data() ), static_cast< std::streamsize >( o_Data.size() ) ) );
+	}
+
+	std::filesystem::path m_Root;
+};
+
+// Cuts the stream of a Serialiser into chunks as it is written, storing the new ones and recording all of them in a manifest.
+class ChunkWriter : public ISegmentWriter
+{
+public:
+
+	ChunkWriter( ChunkStore& a_Store, const Chunker& a_Chunker = Chunker() )
+		: m_Store( a_Store )
+		, m_Chunker( a_Chunker )
+		, m_Buffer( a_Chunker.GetMaxSize() * 2u )
+		, m_Pending( 0u )
+		, m_BytesStored( 0u )
+		, m_IsOpen( false )
+		, m_HasFailed( false )
+	{}
+
+	// Get the chunks of the stream written so far. Complete once the Serialiser is flushed.
+	inline const ChunkManifest& GetManifest() const { return m_Manifest; }
+
+	// Get the bytes of new chunks that were not already in the store.
+	inline uint64_t GetBytesStored() const { return m_BytesStored; }
+
+	// Get whether a chunk could not be written to the store.
+	inline bool HasFailed() const { return m_HasFailed; }
+
+private:
+
+	std::span< byte_t > GetNextSegment( size_t a_Used ) override
+	{
+		m_Pending += m_IsOpen ? a_Used : 0u;
+		m_IsOpen = true;
+		Cut( false );
+
+		// Less than a maximum size chunk is left pending, so at least that much is free.
+		return { m_Buffer.data() + m_Pending, m_Buffer.size() - m_Pending };
+	}
+
+	void Commit( size_t a_Used ) override
+	{
+		m_Pending += m_IsOpen ? a_Used : 0u;
+		m_IsOpen = false;
+		Cut( true );
+	}
+
+	// Store every chunk whose boundary is in the pending bytes, and at the end of the stream, whatever is left.
+	void Cut( bool a_IsFinal )
+	{
+		size_t Offset = 0u;
+
+		while ( Offset < m_Pending )
+		{
+			size_t Size = m_Chunker.FindBoundary( m_Buffer.data() + Offset, m_Pending - Offset );
+
+			if ( !Size )
+			{
+				if ( !a_IsFinal )
+				{
+					break;
+				}
+
+				Size = m_Pending - Offset;
+			}
+
+			const std::span< const byte_t > Chunk( m_Buffer.data() + Offset, Size );
+			const ChunkId Id = ChunkId::Of( Chunk );
+			m_Manifest.Chunks.push_back( { Id, Size } );
+
+			if ( !m_Store.Contains( Id ) )
+			{
+				m_HasFailed |= !m_Store.Put( Id, Chunk );
+				m_BytesStored += Size;
+			}
+
+			Offset += Size;
+		}
+
+		if ( Offset )
+		{
+			memmove( m_Buffer.data(), m_Buffer.data() + Offset, m_Pending - Offset );
+			m_Pending -= Offset;
+		}
+	}
+
+	ChunkStore&           m_Store;
+	Chunker               m_Chunker;
+	std::vector< byte_t > m_Buffer;
+	ChunkManifest         m_Manifest;
+	size_t                m_Pending;
+	uint64_t              m_BytesStored;
+	bool                  m_IsOpen;
+	bool                  m_HasFailed;
+};
+
+// Stitches the chunks of a manifest back into one stream for a Deserialiser, a chunk at a time. A missing or corrupt chunk ends
+// the stream early, so the Deserialiser reports an overflow.
+class ChunkReader : public ISegmentReader
+{
+public:
+
+	ChunkReader( const ChunkStore& a_Store, const ChunkManifest& a_Manifest )
+		: m_Store( a_Store )
+		, m_Manifest( a_Manifest )
+		, m_Index( 0u )
+		, m_HasFailed( false )
+	{}
+
+	std::span< const byte_t > GetNextSegment() override
+	{
+		if ( m_HasFailed || m_Index >= m_Manifest.Chunks.size() )
+		{
+			return {};
+		}
+
+		const ChunkReference& Chunk = m_Manifest.Chunks[ m_Index++ ];
+
+		if ( !m_Store.Get( Chunk.Id, m_Chunk ) || m_Chunk.size() != Chunk.Size )
+		{
+			m_HasFailed = true;
+			return {};
+		}
+
+		return m_Chunk;
+	}
+
+	// Get whether a chunk was missing or corrupt.
+	inline bool HasFailed() const { return m_HasFailed; }
+
+private:
+
+	const ChunkStore&     m_Store;
+	const ChunkManifest&  m_Manifest;
+	std::vector< byte_t > m_Chunk;
+	size_t                m_Index;
+	bool                  m_HasFailed;
+};
@@ -0,0 +1,524 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/Hasher.hpp>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#define COMPARER_AVX2 1
+#elif defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define COMPARER_SSE2 1
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#include <arm_neon.h>
+#define COMPARER_NEON 1
+#endif
+
+//==========================================================================
+// A Comparer walks two objects of the same type side by side through their
+// OnSerialise hooks and reports the paths of what differs between them,
+// without serialising either. Like a FlatBuilder, it is driven by hooks
+// templated on the archive:
+// Comparer comparer;
+//
+// if ( comparer.Compare( Sent, World ) )
+// {
+//     for ( size_t i = 0; i < comparer.GetChangeCount(); ++i )
+//     {
+//         std::span< const size_t > Path = comparer.GetChange( i ); // e.g. { 2, 17, 0 }
+//     }
+// }
+//
+// A path holds, from the outermost in, the index of each field in the order
+// its hook writes them, and the index of each element within a container.
+// Pairs and tuples are fields 0 and 1 onwards, so a changed value in a map
+// is { ..., Element, 1 }. A container of a different length is reported at
+// its own path, after any changes to the elements the two have in common.
+// Unordered maps and sets are matched by key rather than position, with
+// elements numbered by their position in the second object.
+//
+// Ranges of trivially copyable elements, such as vectors and strings, are
+// compared in bulk with AVX2, SSE2 or NEON, and only the elements whose
+// bytes differ are reported. Objects with only an OnSerialise taking a
+// Serialiser cannot be walked, so they are compared by the Hasher digest of
+// their serialised form and reported as a whole.
+//
+// The first object's hook is run to note where each of its fields is, then
+// the second object's to compare against them. Only fields that are members
+// of the object are kept by address. Fields written as temporaries, such as
+// a_Archive << AsShuffled( Samples ), or as locals of the hook, such as a
+// count, are gone by then: trivially copyable ones are copied as they are
+// written, and the rest are compared by the Hasher digest of their serialised
+// form and reported as a whole, so fields to be compared element by element
+// must be members. A hook that writes a different sequence of fields for the
+// two objects reports the whole object as changed.
+//==========================================================================
+class Comparer
+{
+public:
+
+	// Compare two objects, replacing the changes of any earlier comparison. Returns whether they differ.
+	template < typename T >
+	bool Compare( const T& a_First, const T& a_Second )
+	{
+		m_Path.clear();
+		m_Changes.clear();
+		m_Ends.clear();
+		m_Fields.clear();
+		m_Copies.clear();
+		m_Cursor = m_End = 0u;
+		m_IsRecording = false;
+		m_IsMismatched = false;
+
+		CompareValue( a_First, a_Second );
+		return !m_Ends.empty();
+	}
+
+	// Get whether the last comparison found any change.
+	inline bool IsChanged() const { return !m_Ends.empty(); }
+
+	inline size_t GetChangeCount() const { return m_Ends.size(); }
+
+	// Get the path of a change, from the outermost field or element in.
+	inline std::span< const size_t > GetChange( size_t a_Index ) const
+	{
+		const size_t Begin = a_Index ? m_Ends[ a_Index - 1u ] : 0u;
+		return std::span< const size_t >( m_Changes.data() + Begin, m_Ends[ a_Index ] - Begin );
+	}
+
+	// Called by hooks for each of their fields, in order. The first object's members are kept by address, and any other field,
+	// such as a local of the hook, is copied if trivially copyable and otherwise hashed, as it may be gone by the second hook.
+	template < typename T >
+	Comparer& operator<<( const T& a_Field )
+	{
+		constexpr bool IsCopied = IsMemory< T > || ( std::is_array_v< T > && IsMemory< std::remove_all_extents_t< T > > );
+
+		if ( m_IsRecording )
+		{
+			const uintptr_t Address = reinterpret_cast< uintptr_t >( std::addressof( a_Field ) );
+
+			if ( Address >= m_Object && Address + sizeof( T ) <= m_ObjectEnd )
+			{
+				m_Fields.push_back( Field{ std::addressof( a_Field ), &Tag< T > } );
+			}
+			else if constexpr ( IsCopied )
+			{
+				const auto* Bytes = reinterpret_cast< const byte_t* >( std::addressof( a_Field ) );
+				m_Fields.push_back( Field{ nullptr, &Tag< T >, {}, m_Copies.size() } );
+				m_Copies.insert( m_Copies.end(), Bytes, Bytes + sizeof( T ) );
+			}
+			else
+			{
+				m_Fields.push_back( Field{ nullptr, &Tag< T >, Hasher::Hash128( a_Field ) } );
+			}
+		}
+		else if ( m_Cursor == m_End || m_Fields[ m_Cursor ].Type != &Tag< T > )
+		{
+			m_IsMismatched = true;
+			m_Cursor = m_End;
+		}
+		else
+		{
+			const Field& First = m_Fields[ m_Cursor ];
+			m_Path.push_back( m_Cursor++ - m_Begin );
+
+			if ( First.Object )
+			{
+				CompareValue( *static_cast< const T* >( First.Object ), a_Field );
+			}
+			else if constexpr ( IsCopied )
+			{
+				const byte_t* Copy = m_Copies.data() + First.Copy;
+
+				if constexpr ( std::is_array_v< T > )
+				{
+					CompareBytes( Copy, std::addressof( a_Field ), std::extent_v< T >, sizeof( T ) / std::extent_v< T > );
+				}
+				else if ( memcmp( Copy, std::addressof( a_Field ), sizeof( T ) ) )
+				{
+					Report();
+				}
+			}
+			else if ( First.Digest != Hasher::Hash128( a_Field ) )
+			{
+				Report();
+			}
+
+			m_Path.pop_back();
+		}
+
+		return *this;
+	}
+
+	// Called by hooks for a field written through a temporary, such as an AsShuffled wrapper. The temporary is gone by the time the
+	// second hook runs, so the first object's is hashed as it is written, and the second's is compared with that digest.
+	template < typename T > requires ( !std::is_lvalue_reference_v< T > )
+	Comparer& operator<<( T&& a_Field )
+	{
+		if ( m_IsRecording )
+		{
+			m_Fields.push_back( Field{ nullptr, &Tag< T&& >, Hasher::Hash128( a_Field ) } );
+		}
+		else if ( m_Cursor == m_End || m_Fields[ m_Cursor ].Type != &Tag< T&& > )
+		{
+			m_IsMismatched = true;
+			m_Cursor = m_End;
+		}
+		else
+		{
+			m_Path.push_back( m_Cursor - m_Begin );
+
+			if ( m_Fields[ m_Cursor++ ].Digest != Hasher::Hash128( a_Field ) )
+			{
+				Report();
+			}
+
+			m_Path.pop_back();
+		}
+
+		return *this;
+	}
+
+	// Get the offset of the first byte that differs between two buffers, at or after a_Offset, or a_Size if none do.
+	static size_t FindMismatch( const void* a_First, const void* a_Second, size_t a_Offset, size_t a_Size )
+	{
+		auto* First = static_cast< const byte_t* >( a_First );
+		auto* Second = static_cast< const byte_t* >( a_Second );
+		size_t i = a_Offset;
+
+#if defined( COMPARER_AVX2 )
+		for ( ; i + 32u <= a_Size; i += 32u )
+		{
+			const __m256i Equal = _mm256_cmpeq_epi8( _mm256_loadu_si256( reinterpret_cast< const __m256i* >( First + i ) ), _mm256_loadu_si256( reinterpret_cast< const __m256i* >( Second + i ) ) );
+			const uint32_t Mask = ~static_cast< uint32_t >( _mm256_movemask_epi8( Equal ) );
+
+			if ( Mask )
+			{
+				return i + std::countr_zero( Mask );
+			}
+		}
+#elif defined( COMPARER_SSE2 )
+		for ( ; i + 16u <= a_Size; i += 16u )
+		{
+			const __m128i Equal = _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( First + i ) ), _mm_loadu_si128( reinterpret_cast< const __m128i* >( Second + i ) ) );
+			const uint32_t Mask = ~static_cast< uint32_t >( _mm_movemask_epi8( Equal ) ) & 0xFFFFu;
+
+			if ( Mask )
+			{
+				return i + std::countr_zero( Mask );
+			}
+		}
+#elif defined( COMPARER_NEON )
+		for ( ; i + 16u <= a_Size; i += 16u )
+		{
+			const uint8x16_t Equal = vceqq_u8( vld1q_u8( reinterpret_cast< const uint8_t* >( First + i ) ), vld1q_u8( reinterpret_cast< const uint8_t* >( Second + i ) ) );
+
+			if ( vminvq_u8( Equal ) != 0xFFu )
+			{
+				break;
+			}
+		}
+#endif
+
+		for ( ; i < a_Size; ++i )
+		{
+			if ( First[ i ] != Second[ i ] )
+			{
+				return i;
+			}
+		}
+
+		return a_Size;
+	}
+
+private:
+
+	// A field written by the first object's hook, with a tag of its type. Fields that are not members are kept as a copy of their
+	// bytes at an offset into the copies, or as the digest of their serialised form.
+	struct Field
+	{
+		const void*         Object;
+		const char*         Type;
+		FastHash::Digest128 Digest = {};
+		size_t              Copy = 0u;
+	};
+
+	// One distinct address per type, to check that both hooks write the same sequence of field types.
+	template < typename T >
+	static constexpr char Tag = 0;
+
+	// Reaches the container within a queue, stack or priority queue.
+	template < typename Adaptor >
+	struct AdaptorAccess : Adaptor
+	{
+		static const auto& Get( const Adaptor& a_Adaptor ) { return a_Adaptor.*&AdaptorAccess::c; }
+	};
+
+	template < typename T >
+	static constexpr bool IsMemory = Serialisation::Dispatch< T >::IsMemory && !Serialisation::HasOnSerialiseFor< T, Comparer >;
+
+	// Contiguous ranges of trivially copyable elements are compared in bulk.
+	template < typename T >
+	static constexpr bool IsMemoryRange()
+	{
+		if constexpr ( requires( const T& a_Range ) { *a_Range.data(); a_Range.size(); } )
+		{
+			return IsMemory< std::remove_cvref_t< decltype( *std::declval< const T& >().data() ) > >;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// Unordered containers holding each key at most once.
+	template < typename T >
+	static constexpr bool IsUniqueUnordered = requires( T& a_Container, const typename T::value_type& a_Value )
+	{
+		typename T::hasher;
+		a_Container.insert( a_Value ).second;
+	};
+
+	template < typename T >
+	void CompareValue( const T& a_First, const T& a_Second )
+	{
+		if constexpr ( Serialisation::HasOnSerialiseFor< T, Comparer > )
+		{
+			CompareObject( a_First, a_Second );
+		}
+		else if constexpr ( std::is_array_v< T > && IsMemory< std::remove_all_extents_t< T > > )
+		{
+			CompareRange( a_First, a_Second, std::extent_v< T > );
+		}
+		else if constexpr ( IsMemoryRange< T >() )
+		{
+			const size_t Count = a_First.size() < a_Second.size() ? a_First.size() : a_Second.size();
+			CompareRange( a_First.data(), a_Second.data(), Count );
+
+			if ( a_First.size() != a_Second.size() )
+			{
+				Report();
+			}
+		}
+		else if constexpr ( IsMemory< T > )
+		{
+			if ( memcmp( &a_First, &a_Second, sizeof( T ) ) )
+			{
+				Report();
+			}
+		}
+		else if constexpr ( requires { std::tuple_size< T >::value; } )
+		{
+			CompareMembers( a_First, a_Second, std::make_index_sequence< std::tuple_size_v< T > >() );
+		}
+		else if constexpr ( requires { typename T::container_type; } )
+		{
+			CompareValue( AdaptorAccess< T >::Get( a_First ), AdaptorAccess< T >::Get( a_Second ) );
+		}
+		else if constexpr ( IsUniqueUnordered< T > )
+		{
+			CompareByKey( a_First, a_Second );
+		}
+		else if constexpr ( requires { std::begin( a_First ); std::end( a_First ); } )
+		{
+			CompareElements( a_First, a_Second );
+		}
+		else if constexpr ( requires { *a_First; static_cast< bool >( a_First ); } )
+		{
+			if ( static_cast< bool >( a_First ) != static_cast< bool >( a_Second ) )
+			{
+				Report();
+			}
+			else if ( a_First )
+			{
+				CompareValue( *a_First, *a_Second );
+			}
+		}
+		else
+		{
+			if ( Hasher::Hash128( a_First ) != Hasher::Hash128( a_Second ) )
+			{
+				Report();
+			}
+		}
+	}
+
+	// Note the fields of the first object, then compare the second's against them.
+	template < typename T >
+	void CompareObject( const T& a_First, const T& a_Second )
+	{
+		if constexpr ( !Serialisation::Dispatch< T >::IsExact )
+		{
+			if ( typeid( a_First ) != typeid( a_Second ) )
+			{
+				Report();
+				return;
+			}
+		}
+
+		const size_t Begin = m_Fields.size();
+		const size_t CopiesBegin = m_Copies.size();
+
+		Serialisation::InvokeBeforeSerialise( a_First );
+		m_Object = reinterpret_cast< uintptr_t >( std::addressof( a_First ) );
+		m_ObjectEnd = m_Object + sizeof( T );
+		m_IsRecording = true;
+		Serialisation::InvokeSerialiseFor( *this, a_First );
+		m_IsRecording = false;
+		Serialisation::InvokeAfterSerialise( a_First );
+
+		const size_t OuterBegin = m_Begin;
+		const size_t OuterCursor = m_Cursor;
+		const size_t OuterEnd = m_End;
+		const bool OuterMismatched = m_IsMismatched;
+		m_Begin = m_Cursor = Begin;
+		m_End = m_Fields.size();
+		m_IsMismatched = false;
+
+		Serialisation::InvokeBeforeSerialise( a_Second );
+		Serialisation::InvokeSerialiseFor( *this, a_Second );
+		Serialisation::InvokeAfterSerialise( a_Second );
+
+		if ( m_IsMismatched || m_Cursor != m_End )
+		{
+			Report();
+		}
+
+		m_Fields.resize( Begin );
+		m_Copies.resize( CopiesBegin );
+		m_Begin = OuterBegin;
+		m_Cursor = OuterCursor;
+		m_End = OuterEnd;
+		m_IsMismatched = OuterMismatched;
+	}
+
+	template < typename T, size_t... Index >
+	void CompareMembers( const T& a_First, const T& a_Second, std::index_sequence< Index... > )
+	{
+		( ( m_Path.push_back( Index ), CompareValue( std::get< Index >( a_First ), std::get< Index >( a_Second ) ), m_Path.pop_back() ), ... );
+	}
+
+	// Report each element whose bytes differ.
+	template < typename T >
+	void CompareRange( const T* a_First, const T* a_Second, size_t a_Count )
+	{
+		CompareBytes( a_First, a_Second, a_Count, sizeof( T ) );
+	}
+
+	// Report each of a_Count elements of a_Stride bytes whose bytes differ.
+	void CompareBytes( const void* a_First, const void* a_Second, size_t a_Count, size_t a_Stride )
+	{
+		const size_t Size = a_Count * a_Stride;
+
+		for ( size_t Offset = 0u; ( Offset = FindMismatch( a_First, a_Second, Offset, Size ) ) < Size; )
+		{
+			const size_t Index = Offset / a_Stride;
+			m_Path.push_back( Index );
+			Report();
+			m_Path.pop_back();
+			Offset = ( Index + 1u ) * a_Stride;
+		}
+	}
+
+	// Compare elements in order, as far as the shorter container goes.
+	template < typename T >
+	void CompareElements( const T& a_First, const T& a_Second )
+	{
+		auto First = std::begin( a_First );
+		auto Second = std::begin( a_Second );
+		size_t Index = 0u;
+
+		for ( ; First != std::end( a_First ) && Second != std::end( a_Second ); ++First, ++Second, ++Index )
+		{
+			m_Path.push_back( Index );
+
+			if constexpr ( std::is_same_v< std::ranges::range_value_t< const T >, bool > )
+			{
+				if ( static_cast< bool >( *First ) != static_cast< bool >( *Second ) )
+				{
+					Report();
+				}
+			}
+			else
+			{
+				CompareValue( *First, *Second );
+			}
+
+			m_Path.pop_back();
+		}
+
+		if ( First != std::end( a_First ) || Second != std::end( a_Second ) )
+		{
+			Report();
+		}
+	}
+
+	// Match the elements of unique unordered containers by key, whose order depends on their bucket layout.
+	template < typename T >
+	void CompareByKey( const T& a_First, const T& a_Second )
+	{
+		size_t Index = 0u;
+
+		for ( auto Second = a_Second.begin(); Second != a_Second.end(); ++Second, ++Index )
+		{
+			m_Path.push_back( Index );
+
+			if constexpr ( requires { typename T::mapped_type; } )
+			{
+				const auto First = a_First.find( Second->first );
+
+				if ( First == a_First.end() )
+				{
+					Report();
+				}
+				else
+				{
+					m_Path.push_back( 1u );
+					CompareValue( First->second, Second->second );
+					m_Path.pop_back();
+				}
+			}
+			else if ( a_First.find( *Second ) == a_First.end() )
+			{
+				Report();
+			}
+
+			m_Path.pop_back();
+		}
+
+		if ( a_First.size() != a_Second.size() )
+		{
+			Report();
+		}
+	}
+
+	void Report()
+	{
+		m_Changes.insert( m_Changes.end(), m_Path.begin(), m_Path.end() );
+		m_Ends.push_back( m_Changes.size() );
+	}
+
+	std::vector< size_t > m_Path;
+	std::vector< size_t > m_Changes;
+	std::vector< size_t > m_Ends;
+	std::vector< Field >  m_Fields;
+	std::vector< byte_t > m_Copies;
+	uintptr_t             m_Object = 0u;
+	uintptr_t             m_ObjectEnd = 0u;
+	size_t                m_Begin = 0u;
+	size_t                m_Cursor = 0u;
+	size_t                m_End = 0u;
+	bool                  m_IsRecording = false;
+	bool                  m_IsMismatched = false;
+};
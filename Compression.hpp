@@ -0,0 +1,609 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//==========================================================================
+// A small LZ77 block compressor for serialised messages, with optional
+// dictionaries trained from sample messages. Messages of a few hundred bytes
+// barely compress on their own, as there is nothing earlier in them to refer
+// back to. A dictionary holds the content such messages have in common, and
+// matches may reach back into it as if it preceded each message:
+// Compression::Dictionary Dictionary = Compression::Dictionary::Train( Samples, 16 * 1024, 1 );
+//
+// std::vector< byte_t > Frame( Compression::GetCompressBound( Message.size() ) );
+// Frame.resize( Compression::Compress( Message, Frame, &Dictionary ) );
+//
+// Compression::FrameHeader Header;
+// Compression::ReadFrameHeader( Frame, Header );
+// std::vector< byte_t > Message( Header.Size );
+// Compression::Decompress( Frame, Message, &Dictionary );
+//
+// Each frame starts with the ID of the dictionary it was compressed with,
+// zero for none, and the size of the message. Decompression checks the ID
+// and every length and offset against the frame, the output and the
+// dictionary, so corrupt frames fail instead of reading or writing out of
+// bounds.
+//
+// Frames are a sequence of LZ4 style sequences: a token with the literal and
+// match lengths in its high and low nibble, extended by bytes of 255 where
+// a nibble is 15, the literals, then a 16 bit offset. The last sequence has
+// literals only.
+//==========================================================================
+namespace Compression
+{
+// Size of the frame header: the dictionary ID and the message size.
+static constexpr size_t HeaderSize = 8u;
+
+// Shortest match encoded.
+static constexpr size_t MinMatch = 4u;
+
+// Farthest a match can reach back, into the message or the dictionary.
+static constexpr size_t MaxOffset = 65535u;
+
+// Largest usable dictionary. Content beyond the reach of an offset is never referenced.
+static constexpr size_t MaxDictionarySize = MaxOffset;
+
+// Hash table sizes for dictionaries, which are indexed once up front, and for messages, indexed as they are compressed.
+static constexpr unsigned DictionaryHashLog = 14u;
+static constexpr unsigned MaxMessageHashLog = 12u;
+
+// Defaults for training: length of the substrings that are counted across samples, and of the segments that are picked.
+static constexpr size_t TrainingKmer = 8u;
+static constexpr size_t TrainingSegment = 64u;
+
+struct FrameHeader
+{
+	uint32_t DictionaryId;
+	uint32_t Size;
+};
+
+inline uint32_t Read32( const byte_t* a_Source )
+{
+	uint32_t Value;
+	memcpy( &Value, a_Source, sizeof( Value ) );
+	return Value;
+}
+
+inline uint32_t Hash( uint32_t a_Value, unsigned a_Log )
+{
+	return ( a_Value * 2654435761u ) >> ( 32u - a_Log );
+}
+
+// Count the bytes that match from two positions, up to the end of the second.
+inline size_t GetCommonLength( const byte_t* a_First, const byte_t* a_Second, const byte_t* a_SecondEnd )
+{
+	const byte_t* Start = a_Second;
+
+	while ( a_Second + 8u <= a_SecondEnd )
+	{
+		uint64_t First;
+		uint64_t Second;
+		memcpy( &First, a_First, sizeof( First ) );
+		memcpy( &Second, a_Second, sizeof( Second ) );
+
+		if ( const uint64_t Difference = First ^ Second )
+		{
+			// Little endian: the first differing byte is the lowest set one.
+			size_t Bytes = 0u;
+
+			for ( uint64_t Remaining = Difference; !( Remaining & 0xFFu ); Remaining >>= 8u )
+			{
+				++Bytes;
+			}
+
+			return static_cast< size_t >( a_Second - Start ) + Bytes;
+		}
+
+		a_First += 8u;
+		a_Second += 8u;
+	}
+
+	while ( a_Second < a_SecondEnd && *a_First == *a_Second )
+	{
+		++a_First;
+		++a_Second;
+	}
+
+	return static_cast< size_t >( a_Second - Start );
+}
+
+// Content that messages are compressed against, identified in their frames by a non-zero ID.
+class Dictionary
+{
+public:
+
+	Dictionary()
+		: m_Id( 0u )
+	{}
+
+	// Use the given content as a dictionary. Content is truncated from the front to the reach of an offset. The ID must not be
+	// zero, which frames use for no dictionary; Compress ignores a dictionary with an ID of zero.
+	Dictionary( uint32_t a_Id, std::span< const byte_t > a_Content )
+		: m_Id( a_Id )
+		, m_Table( size_t( 1u ) << DictionaryHashLog, 0u )
+	{
+		if ( a_Content.size() > MaxDictionarySize )
+		{
+			a_Content = a_Content.last( MaxDictionarySize );
+		}
+
+		m_Content.assign( a_Content.begin(), a_Content.end() );
+
+		// Later positions overwrite earlier ones, so the closest occurrence of each hash is kept.
+		for ( size_t i = 0; i + MinMatch <= m_Content.size(); ++i )
+		{
+			m_Table[ Hash( Read32( m_Content.data() + i ), DictionaryHashLog ) ] = static_cast< uint32_t >( i + 1u );
+		}
+	}
+
+	// Train a dictionary of up to a_Size bytes from sample messages. Substrings of a_Kmer bytes are counted by how many
+	// samples contain them, then segments of a_Segment bytes are picked greedily by the counts of the distinct substrings
+	// they cover, with the counts of picked substrings cleared so that later segments cover something else. The samples
+	// are split into epochs that each contribute a segment per round, so the dictionary spans the whole sample set.
+	// The highest scoring segments are placed last, where offsets to them are shortest.
+	static Dictionary Train( std::span< const std::span< const byte_t > > a_Samples, size_t a_Size, uint32_t a_Id, size_t a_Kmer = TrainingKmer, size_t a_Segment = TrainingSegment )
+	{
+		struct Count
+		{
+			uint32_t Samples;
+			uint32_t LastSample;
+		};
+
+		const auto GetKmer = [ & ]( const byte_t* a_Source )
+		{
+			uint64_t Kmer = 0u;
+			memcpy( &Kmer, a_Source, a_Kmer < sizeof( Kmer ) ? a_Kmer : sizeof( Kmer ) );
+			return Kmer;
+		};
+
+		a_Size = a_Size < MaxDictionarySize ? a_Size : MaxDictionarySize;
+		a_Kmer = a_Kmer < MinMatch ? MinMatch : a_Kmer > 8u ? 8u : a_Kmer;
+		a_Segment = a_Segment < a_Kmer ? a_Kmer : a_Segment;
+
+		std::unordered_map< uint64_t, Count > Counts;
+
+		for ( size_t s = 0; s < a_Samples.size(); ++s )
+		{
+			for ( size_t i = 0; i + a_Kmer <= a_Samples[ s ].size(); ++i )
+			{
+				Count& Kmer = Counts[ GetKmer( a_Samples[ s ].data() + i ) ];
+
+				if ( Kmer.LastSample != s + 1u )
+				{
+					Kmer.LastSample = static_cast< uint32_t >( s + 1u );
+					++Kmer.Samples;
+				}
+			}
+		}
+
+		// Only substrings shared between samples are worth a place in the dictionary.
+		const auto GetScore = [ & ]( uint64_t a_Value ) -> uint64_t
+		{
+			const auto Found = Counts.find( a_Value );
+			return Found != Counts.end() && Found->second.Samples > 1u ? Found->second.Samples : 0u;
+		};
+
+		std::vector< std::pair< uint64_t, std::span< const byte_t > > > Segments;
+		std::unordered_map< uint64_t, uint32_t > Window;
+		const size_t Epochs = ( std::max< size_t > )( 1u, ( std::min )( a_Samples.size(), ( a_Size + a_Segment - 1u ) / a_Segment ) );
+		size_t Total = 0u;
+
+		for ( bool Picked = true; Picked && Total < a_Size; )
+		{
+			Picked = false;
+
+			for ( size_t Epoch = 0; Epoch < Epochs && Total < a_Size; ++Epoch )
+			{
+				std::span< const byte_t > Best;
+				uint64_t BestScore = 0u;
+
+				for ( size_t s = Epoch * a_Samples.size() / Epochs; s < ( Epoch + 1u ) * a_Samples.size() / Epochs; ++s )
+				{
+					const std::span< const byte_t > Sample = a_Samples[ s ];
+					const size_t Length = Sample.size() < a_Segment ? Sample.size() : a_Segment;
+
+					if ( Length < a_Kmer )
+					{
+						continue;
+					}
+
+					// Slide a window over the sample, scoring each distinct substring in it once.
+					Window.clear();
+					uint64_t Score = 0u;
+
+					for ( size_t i = 0; i + a_Kmer <= Sample.size(); ++i )
+					{
+						const uint64_t Entering = GetKmer( Sample.data() + i );
+
+						if ( Window[ Entering ]++ == 0u )
+						{
+							Score += GetScore( Entering );
+						}
+
+						if ( i + a_Kmer > Length )
+						{
+							const uint64_t Leaving = GetKmer( Sample.data() + i + a_Kmer - Length - 1u );
+
+							if ( --Window[ Leaving ] == 0u )
+							{
+								Score -= GetScore( Leaving );
+							}
+						}
+
+						if ( i + a_Kmer >= Length && Score > BestScore )
+						{
+							BestScore = Score;
+							Best = Sample.subspan( i + a_Kmer - Length, Length );
+						}
+					}
+				}
+
+				if ( BestScore )
+				{
+					for ( size_t i = 0; i + a_Kmer <= Best.size(); ++i )
+					{
+						Counts[ GetKmer( Best.data() + i ) ].Samples = 0u;
+					}
+
+					Segments.push_back( { BestScore, Best } );
+					Total += Best.size();
+					Picked = true;
+				}
+			}
+		}
+
+		std::stable_sort( Segments.begin(), Segments.end(), []( const auto& a_First, const auto& a_Second ) { return a_First.first < a_Second.first; } );
+
+		std::vector< byte_t > Content;
+		Content.reserve( Total );
+
+		for ( const auto& Segment : Segments )
+		{
+			Content.insert( Content.end(), Segment.second.begin(), Segment.second.end() );
+		}
+
+		return Dictionary( a_Id, std::span< const byte_t >( Content ).last( Content.size() < a_Size ? Content.size() : a_Size ) );
+	}
+
+	inline uint32_t GetId() const { return m_Id; }
+
+	inline std::span< const byte_t > GetContent() const { return m_Content; }
+
+	// Get the position after the latest occurrence in the content of a four byte value's hash, or zero if there is none.
+	inline uint32_t Find( uint32_t a_Value ) const { return m_Table.empty() ? 0u : m_Table[ Hash( a_Value, DictionaryHashLog ) ]; }
+
+private:
+
+	uint32_t                m_Id;
+	std::vector< byte_t >   m_Content;
+	std::vector< uint32_t > m_Table;
+};
+
+// Get the largest frame a message of the given size can compress to.
+inline constexpr size_t GetCompressBound( size_t a_Size )
+{
+	return HeaderSize + a_Size + a_Size / 255u + 16u;
+}
+
+// Read the header of a frame. Returns false if the frame is too short to have one.
+inline bool ReadFrameHeader( std::span< const byte_t > a_Frame, FrameHeader& o_Header )
+{
+	if ( a_Frame.size() < HeaderSize )
+	{
+		return false;
+	}
+
+	memcpy( &o_Header.DictionaryId, a_Frame.data(), sizeof( uint32_t ) );
+	memcpy( &o_Header.Size, a_Frame.data() + sizeof( uint32_t ), sizeof( uint32_t ) );
+	return true;
+}
+
+// Compress a message into a frame, against a dictionary if given. Returns the size of the frame, or zero if it
+// does not fit in the output; GetCompressBound() of the message size always fits.
+inline size_t Compress( std::span< const byte_t > a_Message, std::span< byte_t > o_Frame, const Dictionary* a_Dictionary = nullptr )
+{
+	if ( o_Frame.size() < HeaderSize || a_Message.size() > UINT32_MAX )
+	{
+		return 0u;
+	}
+
+	// A frame with a dictionary ID of zero is decompressed without one, so it must not reference a dictionary's content.
+	if ( a_Dictionary && !a_Dictionary->GetId() )
+	{
+		a_Dictionary = nullptr;
+	}
+
+	const FrameHeader Header = { a_Dictionary ? a_Dictionary->GetId() : 0u, static_cast< uint32_t >( a_Message.size() ) };
+	memcpy( o_Frame.data(), &Header.DictionaryId, sizeof( uint32_t ) );
+	memcpy( o_Frame.data() + sizeof( uint32_t ), &Header.Size, sizeof( uint32_t ) );
+
+	const byte_t* Source = a_Message.data();
+	const byte_t* SourceEnd = Source + a_Message.size();
+	byte_t* Output = o_Frame.data() + HeaderSize;
+	byte_t* OutputEnd = o_Frame.data() + o_Frame.size();
+
+	const std::span< const byte_t > Content = a_Dictionary ? a_Dictionary->GetContent() : std::span< const byte_t >();
+
+	const auto WriteLength = [ & ]( size_t a_Length )
+	{
+		for ( ; a_Length >= 255u; a_Length -= 255u )
+		{
+			*Output++ = static_cast< byte_t >( 255u );
+		}
+
+		*Output++ = static_cast< byte_t >( a_Length );
+	};
+
+	// Write a sequence, or only literals if there is no match. Returns false if it does not fit.
+	const auto WriteSequence = [ & ]( const byte_t* a_Literals, size_t a_LiteralLength, size_t a_MatchLength, size_t a_Offset )
+	{
+		const size_t Needed = 1u + a_LiteralLength / 255u + 1u + a_LiteralLength + ( a_MatchLength ? 2u + a_MatchLength / 255u + 1u : 0u );
+
+		if ( static_cast< size_t >( OutputEnd - Output ) < Needed )
+		{
+			return false;
+		}
+
+		const size_t MatchCode = a_MatchLength ? a_MatchLength - MinMatch : 0u;
+		*Output++ = static_cast< byte_t >( ( ( a_LiteralLength < 15u ? a_LiteralLength : 15u ) << 4u ) | ( MatchCode < 15u ? MatchCode : 15u ) );
+
+		if ( a_LiteralLength >= 15u )
+		{
+			WriteLength( a_LiteralLength - 15u );
+		}
+
+		if ( a_LiteralLength )
+		{
+			memcpy( Output, a_Literals, a_LiteralLength );
+			Output += a_LiteralLength;
+		}
+
+		if ( a_MatchLength )
+		{
+			const uint16_t Offset = static_cast< uint16_t >( a_Offset );
+			memcpy( Output, &Offset, sizeof( Offset ) );
+			Output += sizeof( Offset );
+
+			if ( MatchCode >= 15u )
+			{
+				WriteLength( MatchCode - 15u );
+			}
+		}
+
+		return true;
+	};
+
+	// Size the message table to the message, so that small messages do not pay to clear a large one.
+	unsigned HashLog = 8u;
+
+	while ( HashLog < MaxMessageHashLog && ( size_t( 1u ) << HashLog ) < a_Message.size() )
+	{
+		++HashLog;
+	}
+
+	uint32_t Table[ size_t( 1u ) << MaxMessageHashLog ];
+	memset( Table, 0, sizeof( uint32_t ) << HashLog );
+
+	const byte_t* Anchor = Source;
+	const byte_t* Position = Source;
+
+	while ( Position + MinMatch <= SourceEnd )
+	{
+		const uint32_t Value = Read32( Position );
+		const size_t Index = static_cast< size_t >( Position - Source );
+		size_t MatchLength = 0u;
+		size_t Offset = 0u;
+
+		uint32_t& Slot = Table[ Hash( Value, HashLog ) ];
+		const uint32_t Candidate = Slot;
+		Slot = static_cast< uint32_t >( Index + 1u );
+
+		if ( Candidate && Index + 1u - Candidate <= MaxOffset && Read32( Source + Candidate - 1u ) == Value )
+		{
+			MatchLength = MinMatch + GetCommonLength( Source + Candidate - 1u + MinMatch, Position + MinMatch, SourceEnd );
+			Offset = Index + 1u - Candidate;
+		}
+
+		if ( a_Dictionary )
+		{
+			const uint32_t Found = a_Dictionary->Find( Value );
+			const size_t Reach = Index + Content.size() + 1u - Found;
+
+			if ( Found && Reach <= MaxOffset && Found - 1u + MinMatch <= Content.size() && Read32( Content.data() + Found - 1u ) == Value )
+			{
+				// A match in the dictionary can run off its end and on into the start of the message.
+				const byte_t* Reference = Content.data() + Found - 1u + MinMatch;
+				const size_t InDictionary = static_cast< size_t >( Content.data() + Content.size() - Reference );
+				const byte_t* DictionaryEnd = Position + MinMatch + InDictionary < SourceEnd ? Position + MinMatch + InDictionary : SourceEnd;
+				size_t Length = MinMatch + GetCommonLength( Reference, Position + MinMatch, DictionaryEnd );
+
+				if ( Length == MinMatch + InDictionary )
+				{
+					Length += GetCommonLength( Source, Position + Length, SourceEnd );
+				}
+
+				if ( Length > MatchLength )
+				{
+					MatchLength = Length;
+					Offset = Reach;
+				}
+			}
+		}
+
+		if ( !MatchLength )
+		{
+			// Skip ahead faster through data that is not matching.
+			Position += 1u + ( static_cast< size_t >( Position - Anchor ) >> 6u );
+			continue;
+		}
+
+		if ( !WriteSequence( Anchor, static_cast< size_t >( Position - Anchor ), MatchLength, Offset ) )
+		{
+			return 0u;
+		}
+
+		Position += MatchLength;
+		Anchor = Position;
+
+		// Index a position inside the match, so that repeats of its tail are found. Matches are at least MinMatch long.
+		if ( Position + MinMatch - 2u <= SourceEnd )
+		{
+			Table[ Hash( Read32( Position - 2u ), HashLog ) ] = static_cast< uint32_t >( Position - 2u - Source + 1u );
+		}
+	}
+
+	if ( !WriteSequence( Anchor, static_cast< size_t >( SourceEnd - Anchor ), 0u, 0u ) )
+	{
+		return 0u;
+	}
+
+	return static_cast< size_t >( Output - o_Frame.data() );
+}
+
+// Decompress a frame into a message of the size in its header. The frame's dictionary ID must match the given
+// dictionary, or be zero. Returns false if it does not, or if the frame is corrupt.
+inline bool Decompress( std::span< const byte_t > a_Frame, std::span< byte_t > o_Message, const Dictionary* a_Dictionary = nullptr )
+{
+	FrameHeader Header;
+
+	if ( !ReadFrameHeader( a_Frame, Header ) || Header.Size != o_Message.size() )
+	{
+		return false;
+	}
+
+	if ( Header.DictionaryId && ( !a_Dictionary || a_Dictionary->GetId() != Header.DictionaryId ) )
+	{
+		return false;
+	}
+
+	const std::span< const byte_t > Content = Header.DictionaryId ? a_Dictionary->GetContent() : std::span< const byte_t >();
+
+	const byte_t* Input = a_Frame.data() + HeaderSize;
+	const byte_t* InputEnd = a_Frame.data() + a_Frame.size();
+	byte_t* Output = o_Message.data();
+	size_t Produced = 0u;
+
+	const auto ReadLength = [ & ]( size_t& io_Length )
+	{
+		for ( ;; )
+		{
+			if ( Input >= InputEnd )
+			{
+				return false;
+			}
+
+			const size_t Byte = *Input++;
+			io_Length += Byte;
+
+			if ( Byte != 255u )
+			{
+				return true;
+			}
+		}
+	};
+
+	while ( Input < InputEnd )
+	{
+		const size_t Token = *Input++;
+		size_t LiteralLength = Token >> 4u;
+
+		if ( LiteralLength == 15u && !ReadLength( LiteralLength ) )
+		{
+			return false;
+		}
+
+		if ( LiteralLength > static_cast< size_t >( InputEnd - Input ) || LiteralLength > o_Message.size() - Produced )
+		{
+			return false;
+		}
+
+		if ( LiteralLength )
+		{
+			memcpy( Output + Produced, Input, LiteralLength );
+			Input += LiteralLength;
+			Produced += LiteralLength;
+		}
+
+		// The last sequence has no match.
+		if ( Input == InputEnd )
+		{
+			break;
+		}
+
+		if ( InputEnd - Input < 2 )
+		{
+			return false;
+		}
+
+		uint16_t Offset;
+		memcpy( &Offset, Input, sizeof( Offset ) );
+		Input += sizeof( Offset );
+
+		size_t MatchLength = Token & 15u;
+
+		if ( MatchLength == 15u && !ReadLength( MatchLength ) )
+		{
+			return false;
+		}
+
+		MatchLength += MinMatch;
+
+		if ( !Offset || Offset > Produced + Content.size() || MatchLength > o_Message.size() - Produced )
+		{
+			return false;
+		}
+
+		// Copy the part of the match that lies in the dictionary, then the part in the message.
+		if ( Offset > Produced )
+		{
+			const size_t Back = Offset - Produced;
+			const size_t Length = MatchLength < Back ? MatchLength : Back;
+			memcpy( Output + Produced, Content.data() + Content.size() - Back, Length );
+			Produced += Length;
+			MatchLength -= Length;
+		}
+
+		if ( MatchLength )
+		{
+			const byte_t* Reference = Output + Produced - Offset;
+
+			if ( Offset >= MatchLength )
+			{
+				memcpy( Output + Produced, Reference, MatchLength );
+			}
+			else
+			{
+				// Overlapping matches repeat the bytes just written.
+				for ( size_t i = 0; i < MatchLength; ++i )
+				{
+					Output[ Produced + i ] = Reference[ i ];
+				}
+			}
+
+			Produced += MatchLength;
+		}
+	}
+
+	return Produced == o_Message.size();
+}
+
+// Decompress a frame with whichever of the dictionaries its header identifies.
+inline bool Decompress( std::span< const byte_t > a_Frame, std::span< byte_t > o_Message, std::span< const Dictionary > a_Dictionaries )
+{
+	FrameHeader Header;
+
+	if ( !ReadFrameHeader( a_Frame, Header ) )
+	{
+		return false;
+	}
+
+	const auto Found = std::find_if( a_Dictionaries.begin(), a_Dictionaries.end(), [ & ]( const Dictionary& a_Dictionary ) { return a_Dictionary.GetId() == Header.DictionaryId; } );
+	return Decompress( a_Frame, o_Message, Found != a_Dictionaries.end() ? &*Found : nullptr );
+}
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//==========================================================================
+// A bundled implementation of the 64 bit xxHash (XXH64), for fingerprinting
+// and content addressing serialised data without an external dependency.
+// Digests match the reference implementation. Hashing is either one shot:
+// uint64_t Digest = FastHash::Hash64( Data, Size );
+//
+// or streamed, in pieces of any size, with the same result:
+// FastHash::State State;
+// State.Update( Header, HeaderSize );
+// State.Update( Payload, PayloadSize );
+// uint64_t Digest = State.Digest();
+//
+// These are not cryptographic hashes. Hash128 pairs two differently seeded
+// digests, for identifiers that must not collide by chance among very many
+// distinct inputs.
+//==========================================================================
+namespace FastHash
+{
+static constexpr uint64_t Prime1 = 11400714785074694791ull;
+static constexpr uint64_t Prime2 = 14029467366897019727ull;
+static constexpr uint64_t Prime3 = 1609587929392839161ull;
+static constexpr uint64_t Prime4 = 9650029242287828579ull;
+static constexpr uint64_t Prime5 = 2870177450012600261ull;
+
+// Bytes consumed per step by the four accumulators.
+static constexpr size_t StripeSize = 32u;
+
+// Seed of the second half of a Hash128.
+static constexpr uint64_t SecondSeed = 0x9E3779B97F4A7C15ull;
+
+struct Digest128
+{
+	uint64_t Low;
+	uint64_t High;
+
+	friend bool operator==( const Digest128&, const Digest128& ) = default;
+};
+
+inline uint64_t RotateLeft( uint64_t a_Value, unsigned a_Bits )
+{
+	return ( a_Value << a_Bits ) | ( a_Value >> ( 64u - a_Bits ) );
+}
+
+inline uint64_t Read64( const uint8_t* a_Source )
+{
+	uint64_t Value;
+	memcpy( &Value, a_Source, sizeof( Value ) );
+	return Value;
+}
+
+inline uint32_t Read32( const uint8_t* a_Source )
+{
+	uint32_t Value;
+	memcpy( &Value, a_Source, sizeof( Value ) );
+	return Value;
+}
+
+inline uint64_t Round( uint64_t a_Accumulator, uint64_t a_Input )
+{
+	return RotateLeft( a_Accumulator + a_Input * Prime2, 31u ) * Prime1;
+}
+
+inline uint64_t MergeRound( uint64_t a_Hash, uint64_t a_Accumulator )
+{
+	return ( a_Hash ^ Round( 0u, a_Accumulator ) ) * Prime1 + Prime4;
+}
+
+// Mix in the last bytes, fewer than a stripe, and avalanche.
+inline uint64_t Finalise( uint64_t a_Hash, const uint8_t* a_Source, size_t a_Size )
+{
+	for ( ; a_Size >= 8u; a_Size -= 8u, a_Source += 8u )
+	{
+		a_Hash = RotateLeft( a_Hash ^ Round( 0u, Read64( a_Source ) ), 27u ) * Prime1 + Prime4;
+	}
+
+	if ( a_Size >= 4u )
+	{
+		a_Hash = RotateLeft( a_Hash ^ ( static_cast< uint64_t >( Read32( a_Source ) ) * Prime1 ), 23u ) * Prime2 + Prime3;
+		a_Source += 4u;
+		a_Size -= 4u;
+	}
+
+	for ( ; a_Size; --a_Size, ++a_Source )
+	{
+		a_Hash = RotateLeft( a_Hash ^ ( *a_Source * Prime5 ), 11u ) * Prime1;
+	}
+
+	a_Hash ^= a_Hash >> 33u;
+	a_Hash *= Prime2;
+	a_Hash ^= a_Hash >> 29u;
+	a_Hash *= Prime3;
+	a_Hash ^= a_Hash >> 32u;
+	return a_Hash;
+}
+
+// Incremental XXH64 over data supplied in pieces.
+class State
+{
+public:
+
+	State( uint64_t a_Seed = 0u )
+	{
+		Reset( a_Seed );
+	}
+
+	void Reset( uint64_t a_Seed = 0u )
+	{
+		m_Accumulators[ 0 ] = a_Seed + Prime1 + Prime2;
+		m_Accumulators[ 1 ] = a_Seed + Prime2;
+		m_Accumulators[ 2 ] = a_Seed;
+		m_Accumulators[ 3 ] = a_Seed - Prime1;
+		m_Seed = a_Seed;
+		m_Size = 0u;
+		m_Buffered = 0u;
+	}
+
+	void Update( const void* a_Data, size_t a_Size )
+	{
+		auto* Source = static_cast< const uint8_t* >( a_Data );
+		m_Size += a_Size;
+
+		// Top up a partial stripe first.
+		if ( m_Buffered && a_Size )
+		{
+			const size_t Size = StripeSize - m_Buffered < a_Size ? StripeSize - m_Buffered : a_Size;
+			memcpy( m_Buffer + m_Buffered, Source, Size );
+			m_Buffered += Size;
+			Source += Size;
+			a_Size -= Size;
+
+			if ( m_Buffered < StripeSize )
+			{
+				return;
+			}
+
+			Consume( m_Buffer );
+			m_Buffered = 0u;
+		}
+
+		for ( ; a_Size >= StripeSize; a_Size -= StripeSize, Source += StripeSize )
+		{
+			Consume( Source );
+		}
+
+		if ( a_Size )
+		{
+			memcpy( m_Buffer, Source, a_Size );
+			m_Buffered = a_Size;
+		}
+	}
+
+	// Get the hash of everything supplied so far. More data may still be supplied after.
+	uint64_t Digest() const
+	{
+		uint64_t Hash;
+
+		if ( m_Size >= StripeSize )
+		{
+			Hash = RotateLeft( m_Accumulators[ 0 ], 1u ) + RotateLeft( m_Accumulators[ 1 ], 7u ) + RotateLeft( m_Accumulators[ 2 ], 12u ) + RotateLeft( m_Accumulators[ 3 ], 18u );
+
+			for ( const uint64_t Accumulator : m_Accumulators )
+			{
+				Hash = MergeRound( Hash, Accumulator );
+			}
+		}
+		else
+		{
+			Hash = m_Seed + Prime5;
+		}
+
+		return Finalise( Hash + m_Size, m_Buffer, m_Buffered );
+	}
+
+private:
+
+	inline void Consume( const uint8_t* a_Stripe )
+	{
+		m_Accumulators[ 0 ] = Round( m_Accumulators[ 0 ], Read64( a_Stripe ) );
+		m_Accumulators[ 1 ] = Round( m_Accumulators[ 1 ], Read64( a_Stripe + 8u ) );
+		m_Accumulators[ 2 ] = Round( m_Accumulators[ 2 ], Read64( a_Stripe + 16u ) );
+		m_Accumulators[ 3 ] = Round( m_Accumulators[ 3 ], Read64( a_Stripe + 24u ) );
+	}
+
+	uint64_t m_Accumulators[ 4 ];
+	uint64_t m_Seed;
+	uint64_t m_Size;
+	uint8_t  m_Buffer[ StripeSize ];
+	size_t   m_Buffered;
+};
+
+inline uint64_t Hash64( const void* a_Data, size_t a_Size, uint64_t a_Seed = 0u )
+{
+	State Stream( a_Seed );
+	Stream.Update( a_Data, a_Size );
+	return Stream.Digest();
+}
+
+inline Digest128 Hash128( const void* a_Data, size_t a_Size )
+{
+	return { Hash64( a_Data, a_Size ), Hash64( a_Data, a_Size, SecondSeed ) };
+}
+}
@@ -0,0 +1,468 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+//==========================================================================
+// Flat buffers are an output format for read-mostly data that is navigated
+// in place, with no deserialisation step. A FlatBuilder is driven by the
+// same OnSerialise hooks as a Serialiser, as long as the hook is templated
+// on the archive:
+// struct Mesh
+// {
+//     std::string          Name;
+//     std::vector< float > Vertices;
+//     Transform            Pose; // Also has a templated OnSerialise.
+//
+// private:
+//
+//     friend class Serialisation;
+//
+//     template < typename Archive >
+//     void OnSerialise( Archive& a_Archive ) const
+//     {
+//         a_Archive << Name << Vertices << Pose;
+//     }
+// };
+//
+// int main()
+// {
+//     FlatBuilder builder;
+//     builder << mesh;
+//
+//     std::vector< byte_t > Buffer;
+//     builder.Finish( Buffer );
+//
+//     if ( FlatTable::Verify( Buffer.data(), Buffer.size() ) )
+//     {
+//         FlatTable Mesh = FlatTable::Root( Buffer.data() ).GetTable( 0 );
+//         std::string_view Name = Mesh.GetString( 0 );
+//         std::span< const float > Vertices = Mesh.GetSpan< float >( 1 );
+//         FlatTable Pose = Mesh.GetTable( 2 );
+//     }
+//
+//     return 0;
+// }
+//
+// Every object becomes a table holding one 8 byte slot per field written by
+// its hook, so any field is found in constant time. By field type a slot holds:
+// - Scalar: a trivially copyable value of up to 8 bytes, stored inline.
+// - Blob: a string, a larger trivially copyable value or a contiguous range
+//   of trivially copyable values, stored out of line at its natural alignment
+//   (at least 16 bytes) as a 32 bit relative offset and a 32 bit byte count.
+// - Table: a nested object, pair or tuple, or a range of elements that are
+//   not trivially copyable (one field per element), stored as a 32 bit
+//   relative offset to the child table.
+// Top level fields are written to an implicit root table. Children are
+// written before their parent, so every offset points backwards and a
+// buffer can be verified in a single linear pass.
+//==========================================================================
+
+namespace FlatFormat
+{
+enum class Kind : uint8_t
+{
+	Scalar = 1,
+	Blob = 2,
+	Table = 3,
+};
+
+struct Header
+{
+	uint32_t Magic;
+	uint32_t Size;
+	uint32_t Root;
+	uint32_t Reserved;
+};
+
+static constexpr uint32_t Magic = 0x54414C46u; // "FLAT"
+static constexpr size_t SlotSize = 8u;
+static constexpr size_t TableAlignment = 8u;
+static constexpr size_t BlobAlignment = 16u;
+static constexpr size_t MaxDepth = 256u;
+
+// A table is its field count, one kind byte per field, and then 8 byte aligned slots.
+inline size_t GetSlotsOffset( uint32_t a_FieldCount )
+{
+	return ( sizeof( uint32_t ) + a_FieldCount + SlotSize - 1u ) & ~( SlotSize - 1u );
+}
+} // FlatFormat
+
+// Builds a flat buffer from objects whose OnSerialise is templated on the archive.
+class FlatBuilder
+{
+public:
+
+	FlatBuilder()
+		: m_Depth( 0u )
+	{
+		Reset();
+	}
+
+	// Add the object as the next field of the table being built.
+	template < typename T >
+	inline FlatBuilder& operator<<( const T& a_Object )
+	{
+		AddField( a_Object );
+		return *this;
+	}
+
+	// Close the root table and move the finished buffer out. Returns false if the buffer outgrew its 32 bit offsets.
+	bool Finish( std::vector< byte_t >& o_Buffer )
+	{
+		const uint32_t Root = static_cast< uint32_t >( WriteTable( m_Tables[ 0 ] ) );
+
+		FlatFormat::Header Header{ FlatFormat::Magic, static_cast< uint32_t >( m_Buffer.size() ), Root, 0u };
+		memcpy( m_Buffer.data(), &Header, sizeof( Header ) );
+
+		const bool Succeeded = m_Buffer.size() <= static_cast< size_t >( INT32_MAX );
+		o_Buffer = std::move( m_Buffer );
+		Reset();
+		return Succeeded;
+	}
+
+private:
+
+	struct Field
+	{
+		FlatFormat::Kind Kind;
+		uint32_t         Count;
+		uint64_t         Value; // Inline bytes for scalars, absolute position of the target otherwise.
+	};
+
+	// Types with any serialisation hook are never copied as memory, so one the builder cannot call is reported rather than skipped.
+	template < typename T >
+	static constexpr bool IsMemory = Serialisation::Dispatch< T >::IsMemory && !Serialisation::Dispatch< T >::HasOnSerialise && !Serialisation::HasOnSerialiseFor< T, FlatBuilder >;
+
+	// Contiguous ranges of trivially copyable elements are written as a single blob.
+	template < typename T >
+	static constexpr bool IsMemoryRange()
+	{
+		if constexpr ( requires( const T& a_Range ) { *a_Range.data(); a_Range.size(); } )
+		{
+			return IsMemory< std::remove_cvref_t< decltype( *std::declval< const T& >().data() ) > >;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	template < typename T >
+	void AddField( const T& a_Object )
+	{
+		if constexpr ( Serialisation::HasOnSerialiseFor< T, FlatBuilder > )
+		{
+			BeginTable();
+			Serialisation::InvokeBeforeSerialise( a_Object );
+			Serialisation::InvokeSerialiseFor( *this, a_Object );
+			Serialisation::InvokeAfterSerialise( a_Object );
+			EndTable();
+		}
+		else if constexpr ( requires { typename T::traits_type; a_Object.data(); a_Object.size(); } )
+		{
+			AddBlob( a_Object.data(), sizeof( *a_Object.data() ) * a_Object.size(), alignof( typename T::value_type ), true );
+		}
+		else if constexpr ( std::is_array_v< T > && IsMemory< std::remove_all_extents_t< T > > )
+		{
+			AddBlob( &a_Object, sizeof( a_Object ), alignof( T ), false );
+		}
+		else if constexpr ( IsMemoryRange< T >() )
+		{
+			AddBlob( a_Object.data(), sizeof( *a_Object.data() ) * a_Object.size(), alignof( std::remove_cvref_t< decltype( *a_Object.data() ) > ), false );
+		}
+		else if constexpr ( requires { std::tuple_size< T >::value; } )
+		{
+			BeginTable();
+			std::apply( [ this ]( const auto&... a_Elements ) { ( AddField( a_Elements ), ... ); }, a_Object );
+			EndTable();
+		}
+		else if constexpr ( requires { std::begin( a_Object ); std::end( a_Object ); } )
+		{
+			BeginTable();
+
+			for ( const auto& Element : a_Object )
+			{
+				AddField( Element );
+			}
+
+			EndTable();
+		}
+		else if constexpr ( IsMemory< T > && sizeof( T ) <= FlatFormat::SlotSize )
+		{
+			Field Scalar{ FlatFormat::Kind::Scalar, 0u, 0u };
+			memcpy( &Scalar.Value, &a_Object, sizeof( T ) );
+			m_Tables[ m_Depth ].push_back( Scalar );
+		}
+		else if constexpr ( IsMemory< T > )
+		{
+			AddBlob( &a_Object, sizeof( T ), alignof( T ), false );
+		}
+		else if constexpr ( Serialisation::Dispatch< T >::HasOnSerialise )
+		{
+			static_assert( !Serialisation::Dispatch< T >::HasOnSerialise, "Type's OnSerialise only takes a Serialiser; template it on the archive to be written to a flat buffer." );
+		}
+		else
+		{
+			static_assert( IsMemory< T >, "Type needs an OnSerialise templated on the archive to be written to a flat buffer." );
+		}
+	}
+
+	void AddBlob( const void* a_Data, size_t a_Size, size_t a_Alignment, bool a_IsString )
+	{
+		Field Blob{ FlatFormat::Kind::Blob, static_cast< uint32_t >( a_Size ), 0u };
+
+		if ( a_Size )
+		{
+			Blob.Value = Pad( a_Alignment < FlatFormat::BlobAlignment ? FlatFormat::BlobAlignment : a_Alignment );
+			m_Buffer.resize( Blob.Value + a_Size + ( a_IsString ? a_Alignment : 0u ) );
+			memcpy( m_Buffer.data() + Blob.Value, a_Data, a_Size );
+		}
+
+		m_Tables[ m_Depth ].push_back( Blob );
+	}
+
+	void BeginTable()
+	{
+		if ( ++m_Depth == m_Tables.size() )
+		{
+			m_Tables.emplace_back();
+		}
+	}
+
+	void EndTable()
+	{
+		const size_t Position = WriteTable( m_Tables[ m_Depth-- ] );
+		m_Tables[ m_Depth ].push_back( Field{ FlatFormat::Kind::Table, 0u, Position } );
+	}
+
+	// Write out the table after its children and clear its fields. Returns the table's position.
+	size_t WriteTable( std::vector< Field >& a_Fields )
+	{
+		const uint32_t Count = static_cast< uint32_t >( a_Fields.size() );
+		const size_t Position = Pad( FlatFormat::TableAlignment );
+		const size_t Slots = Position + FlatFormat::GetSlotsOffset( Count );
+
+		m_Buffer.resize( Slots + FlatFormat::SlotSize * Count );
+		memcpy( m_Buffer.data() + Position, &Count, sizeof( Count ) );
+
+		for ( uint32_t i = 0; i < Count; ++i )
+		{
+			const Field& Current = a_Fields[ i ];
+			byte_t* Slot = m_Buffer.data() + Slots + FlatFormat::SlotSize * i;
+			m_Buffer[ Position + sizeof( Count ) + i ] = static_cast< byte_t >( Current.Kind );
+
+			if ( Current.Kind == FlatFormat::Kind::Scalar )
+			{
+				memcpy( Slot, &Current.Value, FlatFormat::SlotSize );
+			}
+			else
+			{
+				const int32_t Offset = Current.Count || Current.Kind == FlatFormat::Kind::Table ? static_cast< int32_t >( static_cast< int64_t >( Current.Value ) - static_cast< int64_t >( Slot - m_Buffer.data() ) ) : 0;
+				memcpy( Slot, &Offset, sizeof( Offset ) );
+				memcpy( Slot + sizeof( Offset ), &Current.Count, sizeof( Current.Count ) );
+			}
+		}
+
+		a_Fields.clear();
+		return Position;
+	}
+
+	// Zero pad the buffer up to the alignment. Returns the aligned position.
+	size_t Pad( size_t a_Alignment )
+	{
+		const size_t Position = ( m_Buffer.size() + a_Alignment - 1u ) & ~( a_Alignment - 1u );
+		m_Buffer.resize( Position );
+		return Position;
+	}
+
+	void Reset()
+	{
+		m_Buffer.assign( sizeof( FlatFormat::Header ), 0u );
+		m_Tables.resize( 1u );
+		m_Tables[ 0 ].clear();
+		m_Depth = 0u;
+	}
+
+	std::vector< byte_t >                m_Buffer;
+	std::vector< std::vector< Field > > m_Tables;
+	size_t                               m_Depth;
+};
+
+// A view of one table within a flat buffer. Accessors read straight from the buffer without any parsing.
+class FlatTable
+{
+public:
+
+	// Check every header, table, offset and byte count of a flat buffer in one linear pass. The buffer must be 16 byte aligned.
+	static bool Verify( const byte_t* a_Data, size_t a_Size )
+	{
+		if ( !a_Data || reinterpret_cast< uintptr_t >( a_Data ) % FlatFormat::BlobAlignment || a_Size < sizeof( FlatFormat::Header ) )
+		{
+			return false;
+		}
+
+		FlatFormat::Header Header;
+		memcpy( &Header, a_Data, sizeof( Header ) );
+
+		if ( Header.Magic != FlatFormat::Magic || Header.Size > a_Size )
+		{
+			return false;
+		}
+
+		return VerifyTable( a_Data, Header.Size, Header.Root, sizeof( Header ), 0u ) == Header.Size;
+	}
+
+	// Get the root table of a verified flat buffer.
+	static FlatTable Root( const byte_t* a_Data )
+	{
+		FlatFormat::Header Header;
+		memcpy( &Header, a_Data, sizeof( Header ) );
+		return FlatTable( a_Data + Header.Root );
+	}
+
+	// Get the number of fields in the table.
+	inline uint32_t GetFieldCount() const
+	{
+		uint32_t Count;
+		memcpy( &Count, m_Table, sizeof( Count ) );
+		return Count;
+	}
+
+	// Get the kind of slot a field was written to.
+	inline FlatFormat::Kind GetKind( size_t a_Field ) const { return static_cast< FlatFormat::Kind >( m_Table[ sizeof( uint32_t ) + a_Field ] ); }
+
+	// Get a copy of a trivially copyable field, whether it was stored inline or as a blob.
+	template < typename T >
+	T Get( size_t a_Field ) const
+	{
+		static_assert( std::is_trivially_copyable_v< T >, "Only trivially copyable fields can be read by value." );
+
+		T Value;
+		memcpy( &Value, sizeof( T ) <= FlatFormat::SlotSize ? GetSlot( a_Field ) : GetBlob( a_Field ), sizeof( T ) );
+		return Value;
+	}
+
+	// Get a contiguous range field in place. The elements are aligned to their natural alignment.
+	template < typename T >
+	std::span< const T > GetSpan( size_t a_Field ) const
+	{
+		return std::span< const T >( reinterpret_cast< const T* >( GetBlob( a_Field ) ), GetBlobSize( a_Field ) / sizeof( T ) );
+	}
+
+	// Get a string field in place.
+	template < typename Char = char >
+	std::basic_string_view< Char > GetString( size_t a_Field ) const
+	{
+		return std::basic_string_view< Char >( reinterpret_cast< const Char* >( GetBlob( a_Field ) ), GetBlobSize( a_Field ) / sizeof( Char ) );
+	}
+
+	// Get a nested object, pair, tuple or range of non trivially copyable elements.
+	FlatTable GetTable( size_t a_Field ) const
+	{
+		return FlatTable( GetSlot( a_Field ) + GetOffset( a_Field ) );
+	}
+
+private:
+
+	explicit FlatTable( const byte_t* a_Table )
+		: m_Table( a_Table )
+	{}
+
+	inline const byte_t* GetSlot( size_t a_Field ) const
+	{
+		return m_Table + FlatFormat::GetSlotsOffset( GetFieldCount() ) + FlatFormat::SlotSize * a_Field;
+	}
+
+	inline int32_t GetOffset( size_t a_Field ) const
+	{
+		int32_t Offset;
+		memcpy( &Offset, GetSlot( a_Field ), sizeof( Offset ) );
+		return Offset;
+	}
+
+	inline const byte_t* GetBlob( size_t a_Field ) const { return GetSlot( a_Field ) + GetOffset( a_Field ); }
+
+	inline uint32_t GetBlobSize( size_t a_Field ) const
+	{
+		uint32_t Size;
+		memcpy( &Size, GetSlot( a_Field ) + sizeof( int32_t ), sizeof( Size ) );
+		return Size;
+	}
+
+	// Verify a table and its children, all of which must lie in order between the cursor and the table.
+	// Returns the end of the table, or 0 if anything is out of place.
+	static size_t VerifyTable( const byte_t* a_Data, size_t a_Size, size_t a_Position, size_t a_Cursor, size_t a_Depth )
+	{
+		if ( a_Depth > FlatFormat::MaxDepth || a_Position % FlatFormat::TableAlignment || a_Position < a_Cursor || a_Position + sizeof( uint32_t ) > a_Size )
+		{
+			return 0u;
+		}
+
+		uint32_t Count;
+		memcpy( &Count, a_Data + a_Position, sizeof( Count ) );
+
+		const size_t Slots = a_Position + FlatFormat::GetSlotsOffset( Count );
+		const size_t End = Slots + FlatFormat::SlotSize * Count;
+
+		if ( Count > a_Size || End > a_Size )
+		{
+			return 0u;
+		}
+
+		for ( uint32_t i = 0; i < Count; ++i )
+		{
+			const size_t Slot = Slots + FlatFormat::SlotSize * i;
+			int32_t Offset;
+			uint32_t Size;
+			memcpy( &Offset, a_Data + Slot, sizeof( Offset ) );
+			memcpy( &Size, a_Data + Slot + sizeof( Offset ), sizeof( Size ) );
+
+			const int64_t Target = static_cast< int64_t >( Slot ) + Offset;
+
+			switch ( static_cast< FlatFormat::Kind >( a_Data[ a_Position + sizeof( Count ) + i ] ) )
+			{
+			case FlatFormat::Kind::Scalar:
+				break;
+
+			case FlatFormat::Kind::Blob:
+				if ( Size )
+				{
+					if ( Target < static_cast< int64_t >( a_Cursor ) || Target % FlatFormat::BlobAlignment || Target + Size > static_cast< int64_t >( a_Position ) )
+					{
+						return 0u;
+					}
+
+					a_Cursor = static_cast< size_t >( Target ) + Size;
+				}
+				break;
+
+			case FlatFormat::Kind::Table:
+				if ( Target < static_cast< int64_t >( a_Cursor ) || Target >= static_cast< int64_t >( a_Position ) )
+				{
+					return 0u;
+				}
+
+				a_Cursor = VerifyTable( a_Data, a_Position, static_cast< size_t >( Target ), a_Cursor, a_Depth + 1u );
+
+				if ( !a_Cursor )
+				{
+					return 0u;
+				}
+				break;
+
+			default:
+				return 0u;
+			}
+		}
+
+		return a_Position < a_Cursor ? 0u : End;
+	}
+
+	const byte_t* m_Table;
+};
@@ -0,0 +1,359 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+//==========================================================================
+// Lossless compression of float and double vectors whose values change
+// slowly, such as time series. Each value is XORed with the one before it,
+// and only the meaningful bits of the result are written, Gorilla style:
+// - 0: the value repeats.
+// - 10: the XOR fits in the window of leading and trailing zeros of the
+//   previous one, and its meaningful bits follow.
+// - 11: the XOR opens a new window. The count of leading zeros and of
+//   meaningful bits follow, then the meaningful bits.
+// Applied per container by wrapping it in the archive expressions of its hooks:
+// a_Serialiser << AsXorCompressed( Samples );
+// a_Deserialiser >> AsXorCompressed( Samples );
+// a_Sizer + AsXorCompressed( Samples );
+//
+// Values are coded in independent blocks, each prefixed by its size in bytes,
+// so a block is encoded and decoded on the stack and streams through the
+// archive without a buffer sized to the whole container. Sizing is exact, by
+// counting the bits of each block; an upper bound sizer bounds each block
+// from its value count instead.
+//==========================================================================
+namespace FloatCompression
+{
+// Values coded per block. The predictor restarts at each block.
+static constexpr size_t BlockSize = 1024u;
+
+template < typename T >
+concept IsFloatVector = requires( T& a_Value ) { a_Value.data(); a_Value.size(); } &&
+	( std::same_as< std::remove_cvref_t< decltype( *std::declval< T& >().data() ) >, float > ||
+	  std::same_as< std::remove_cvref_t< decltype( *std::declval< T& >().data() ) >, double > );
+
+// Bit layout of a floating point type.
+template < typename T >
+struct Layout
+{
+	static_assert( std::is_same_v< T, float > || std::is_same_v< T, double >, "Only float and double are XOR compressed." );
+
+	using Word = std::conditional_t< sizeof( T ) == 8u, uint64_t, uint32_t >;
+
+	static constexpr unsigned Bits = sizeof( T ) * 8u;
+
+	// Width of the leading zero and meaningful bit counts.
+	static constexpr unsigned FieldBits = sizeof( T ) == 8u ? 6u : 5u;
+
+	// Largest encoding of a block: the first value in full, then every other value opening a new window.
+	static constexpr size_t GetMaxBlockBits( size_t a_Count )
+	{
+		return a_Count ? Bits + ( a_Count - 1u ) * ( 2u + 2u * FieldBits + Bits ) : 0u;
+	}
+
+	static constexpr size_t MaxBlockBytes = ( GetMaxBlockBits( BlockSize ) + 7u ) / 8u;
+	static constexpr size_t MaxBlockWords = ( MaxBlockBytes + 7u ) / 8u;
+
+	static_assert( MaxBlockBytes <= UINT16_MAX, "Block sizes are written in 16 bits." );
+};
+
+// Packs bits into 64 bit words, least significant first.
+class BitWriter
+{
+public:
+
+	BitWriter( uint64_t* o_Words )
+		: m_Words( o_Words )
+		, m_Accumulator( 0u )
+		, m_Filled( 0u )
+		, m_Count( 0u )
+	{}
+
+	// Write the low bits of a value. Bits above them must be clear.
+	inline void Write( uint64_t a_Value, unsigned a_Bits )
+	{
+		m_Accumulator |= a_Value << m_Filled;
+
+		if ( m_Filled + a_Bits >= 64u )
+		{
+			m_Words[ m_Count++ ] = m_Accumulator;
+			m_Accumulator = m_Filled ? a_Value >> ( 64u - m_Filled ) : 0u;
+			m_Filled = m_Filled + a_Bits - 64u;
+		}
+		else
+		{
+			m_Filled += a_Bits;
+		}
+	}
+
+	// Flush the last partial word. Returns the number of bytes written.
+	size_t Finish()
+	{
+		if ( m_Filled )
+		{
+			m_Words[ m_Count ] = m_Accumulator;
+		}
+
+		return m_Count * 8u + ( m_Filled + 7u ) / 8u;
+	}
+
+private:
+
+	uint64_t* m_Words;
+	uint64_t  m_Accumulator;
+	unsigned  m_Filled;
+	size_t    m_Count;
+};
+
+// Counts the bits a BitWriter would write.
+class BitCounter
+{
+public:
+
+	inline void Write( uint64_t, unsigned a_Bits ) { m_Bits += a_Bits; }
+
+	inline size_t GetBytes() const { return ( m_Bits + 7u ) / 8u; }
+
+private:
+
+	size_t m_Bits = 0u;
+};
+
+// Reads bits packed by a BitWriter. Reads past the end return zero bits.
+class BitReader
+{
+public:
+
+	// The words must be followed by one zero word.
+	BitReader( const uint64_t* a_Words, size_t a_Bytes )
+		: m_Words( a_Words )
+		, m_Position( 0u )
+		, m_Limit( a_Bytes * 8u )
+	{}
+
+	inline uint64_t Read( unsigned a_Bits )
+	{
+		if ( m_Position + a_Bits > m_Limit )
+		{
+			m_Position = m_Limit;
+			return 0u;
+		}
+
+		const size_t Index = m_Position >> 6u;
+		const unsigned Offset = static_cast< unsigned >( m_Position & 63u );
+		uint64_t Value = m_Words[ Index ] >> Offset;
+
+		if ( Offset + a_Bits > 64u )
+		{
+			Value |= m_Words[ Index + 1u ] << ( 64u - Offset );
+		}
+
+		m_Position += a_Bits;
+		return a_Bits < 64u ? Value & ( ( uint64_t( 1u ) << a_Bits ) - 1u ) : Value;
+	}
+
+private:
+
+	const uint64_t* m_Words;
+	size_t          m_Position;
+	size_t          m_Limit;
+};
+
+template < typename T, typename Writer >
+void EncodeBlock( const T* a_Values, size_t a_Count, Writer& o_Writer )
+{
+	using Word = typename Layout< T >::Word;
+	constexpr unsigned Bits = Layout< T >::Bits;
+	constexpr unsigned FieldBits = Layout< T >::FieldBits;
+
+	if ( !a_Count )
+	{
+		return;
+	}
+
+	Word Previous;
+	memcpy( &Previous, a_Values, sizeof( Previous ) );
+	o_Writer.Write( Previous, Bits );
+
+	// No window is open until the first change, so the first non-zero XOR always opens one.
+	unsigned PreviousLeading = Bits;
+	unsigned PreviousTrailing = 0u;
+	unsigned PreviousMeaningful = 0u;
+
+	for ( size_t i = 1u; i < a_Count; ++i )
+	{
+		Word Current;
+		memcpy( &Current, a_Values + i, sizeof( Current ) );
+		const Word Xor = Current ^ Previous;
+		Previous = Current;
+
+		if ( !Xor )
+		{
+			o_Writer.Write( 0u, 1u );
+			continue;
+		}
+
+		const unsigned Leading = static_cast< unsigned >( std::countl_zero( Xor ) );
+		const unsigned Trailing = static_cast< unsigned >( std::countr_zero( Xor ) );
+
+		if ( Leading >= PreviousLeading && Trailing >= PreviousTrailing )
+		{
+			o_Writer.Write( 0b01u, 2u );
+			o_Writer.Write( Xor >> PreviousTrailing, PreviousMeaningful );
+		}
+		else
+		{
+			const unsigned Meaningful = Bits - Leading - Trailing;
+			o_Writer.Write( 0b11u | ( Leading << 2u ) | ( ( Meaningful - 1u ) << ( 2u + FieldBits ) ), 2u + 2u * FieldBits );
+			o_Writer.Write( Xor >> Trailing, Meaningful );
+
+			PreviousLeading = Leading;
+			PreviousTrailing = Trailing;
+			PreviousMeaningful = Meaningful;
+		}
+	}
+}
+
+template < typename T >
+void DecodeBlock( BitReader& a_Reader, size_t a_Count, T* o_Values )
+{
+	using Word = typename Layout< T >::Word;
+	constexpr unsigned Bits = Layout< T >::Bits;
+	constexpr unsigned FieldBits = Layout< T >::FieldBits;
+
+	if ( !a_Count )
+	{
+		return;
+	}
+
+	Word Previous = static_cast< Word >( a_Reader.Read( Bits ) );
+	memcpy( o_Values, &Previous, sizeof( Previous ) );
+
+	unsigned Trailing = 0u;
+	unsigned Meaningful = 0u;
+
+	for ( size_t i = 1u; i < a_Count; ++i )
+	{
+		if ( a_Reader.Read( 1u ) )
+		{
+			if ( a_Reader.Read( 1u ) )
+			{
+				const unsigned Fields = static_cast< unsigned >( a_Reader.Read( 2u * FieldBits ) );
+				const unsigned Leading = Fields & ( ( 1u << FieldBits ) - 1u );
+				Meaningful = ( Fields >> FieldBits ) + 1u;
+
+				// Only a corrupt stream overruns the word, but it must not shift out of range.
+				Meaningful = Leading + Meaningful > Bits ? Bits - Leading : Meaningful;
+				Trailing = Bits - Leading - Meaningful;
+			}
+
+			Previous ^= static_cast< Word >( a_Reader.Read( Meaningful ) << Trailing );
+		}
+
+		memcpy( o_Values + i, &Previous, sizeof( Previous ) );
+	}
+}
+}
+
+// XOR compression of every value in a std::vector of floats or doubles.
+template < typename T >
+class XorCompressed
+{
+public:
+
+	static_assert( FloatCompression::IsFloatVector< T >, "XOR compression applies to vectors of floats or doubles." );
+
+	using Value = std::remove_cvref_t< decltype( *std::declval< T& >().data() ) >;
+	using Layout = FloatCompression::Layout< Value >;
+
+	XorCompressed( T& a_Value )
+		: m_Value( a_Value )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		const size_t Size = m_Value.size();
+		a_Serialiser.SerialiseAsMemory( &Size, sizeof( Size ) );
+
+		uint64_t Words[ Layout::MaxBlockWords ];
+
+		for ( size_t i = 0; i < Size; i += FloatCompression::BlockSize )
+		{
+			const size_t Count = Size - i < FloatCompression::BlockSize ? Size - i : FloatCompression::BlockSize;
+			FloatCompression::BitWriter Writer( Words );
+			FloatCompression::EncodeBlock( m_Value.data() + i, Count, Writer );
+
+			const uint16_t Bytes = static_cast< uint16_t >( Writer.Finish() );
+			a_Serialiser.SerialiseAsMemory( &Bytes, sizeof( Bytes ) );
+			a_Serialiser.SerialiseAsMemory( Words, Bytes );
+		}
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		// Each block takes at least its two byte size.
+		size_t Size;
+		a_Deserialiser.ReadSize( Size, FloatCompression::BlockSize / sizeof( uint16_t ) );
+		m_Value.resize( Size );
+
+		uint64_t Words[ Layout::MaxBlockWords + 2u ];
+
+		for ( size_t i = 0; i < Size; i += FloatCompression::BlockSize )
+		{
+			const size_t Count = Size - i < FloatCompression::BlockSize ? Size - i : FloatCompression::BlockSize;
+
+			uint16_t Bytes;
+			a_Deserialiser.DeserialiseAsMemory( &Bytes, sizeof( Bytes ) );
+
+			// A corrupt size is clamped so the block stays on the stack; the decoded values are then garbage, but bounded.
+			Bytes = Bytes > Layout::MaxBlockBytes ? static_cast< uint16_t >( Layout::MaxBlockBytes ) : Bytes;
+
+			// Clear the tail of the last word and the padding word the reader may look at.
+			Words[ Bytes / 8u ] = 0u;
+			Words[ Bytes / 8u + 1u ] = 0u;
+			a_Deserialiser.DeserialiseAsMemory( Words, Bytes );
+
+			FloatCompression::BitReader Reader( Words, Bytes );
+			FloatCompression::DecodeBlock( Reader, Count, m_Value.data() + i );
+		}
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		const size_t Size = m_Value.size();
+		size_t Bytes = sizeof( size_t );
+
+		for ( size_t i = 0; i < Size; i += FloatCompression::BlockSize )
+		{
+			const size_t Count = Size - i < FloatCompression::BlockSize ? Size - i : FloatCompression::BlockSize;
+			FloatCompression::BitCounter Counter;
+			FloatCompression::EncodeBlock( m_Value.data() + i, Count, Counter );
+			Bytes += sizeof( uint16_t ) + Counter.GetBytes();
+		}
+
+		a_Sizer.AddSizeOfMemory( Bytes );
+	}
+
+	void OnSizeBound( Sizer& a_Sizer ) const
+	{
+		const size_t Size = m_Value.size();
+		const size_t Blocks = Size / FloatCompression::BlockSize;
+		const size_t Remainder = Size % FloatCompression::BlockSize;
+
+		a_Sizer.AddSizeOfMemory(
+			sizeof( size_t ) +
+			Blocks * ( sizeof( uint16_t ) + Layout::MaxBlockBytes ) +
+			( Remainder ? sizeof( uint16_t ) + ( Layout::GetMaxBlockBits( Remainder ) + 7u ) / 8u : 0u ) );
+	}
+
+private:
+
+	T& m_Value;
+};
+
+template < typename T >
+inline XorCompressed< T > AsXorCompressed( T& a_Value ) { return { a_Value }; }
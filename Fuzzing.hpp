@@ -0,0 +1,376 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/ByteShuffle.hpp>
+#include <Utils/FloatCompression.hpp>
+#include <Utils/Quantisation.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <forward_list>
+#include <list>
+#include <map>
+#include <queue>
+#include <random>
+#include <set>
+#include <span>
+#include <stack>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+//==========================================================================
+// Fuzzing and throughput measurement of the Deserialiser, over one type for
+// every container overload and for the wrappers' encodings. An input is a selector byte picking the type,
+// followed by a stream to decode as it. TestOneInput decodes it checked,
+// then checks that the value re-encodes to the size the Sizer gives and
+// decodes back from that exactly. It fits libFuzzer directly:
+// extern "C" int LLVMFuzzerTestOneInput( const uint8_t* Data, size_t Size )
+// {
+//     return Fuzzing::TestOneInput( Data, Size );
+// }
+//
+// and AFL persistent mode as the body of the __AFL_LOOP. A failed property
+// aborts, which both report as a crash. MakeCorpus serialises random values
+// of every type in the same format, to seed the fuzzer with, and Benchmark
+// decodes such a corpus both checked and unchecked, so that a hardening
+// change is measured on the same inputs it is fuzzed with:
+// std::vector< Fuzzing::Input > Corpus = Fuzzing::MakeCorpus();
+// for ( const Fuzzing::Result& Result : Fuzzing::Benchmark( Corpus ) )
+// {
+//     printf( "%s: %.0f / %.0f MB/s\n", Result.Name, Result.GetCheckedRate() / 1e6, Result.GetUncheckedRate() / 1e6 );
+// }
+//
+// Unchecked decoding trusts the stream, so it is only ever run on a corpus
+// made by MakeCorpus, never on fuzzed input.
+//==========================================================================
+namespace Fuzzing
+{
+// An object with hooks, holding a few containers of its own.
+struct Record
+{
+	int32_t              Id = 0;
+	std::string          Name;
+	std::vector< float > Values;
+
+	void OnSerialise( Serialiser& a_Serialiser ) const { a_Serialiser << Id << Name << Values; }
+	void OnDeserialise( Deserialiser& a_Deserialiser ) { a_Deserialiser >> Id >> Name >> Values; }
+	void OnSize( Sizer& a_Sizer ) const { a_Sizer + Id + Name + Values; }
+};
+
+// C arrays, which can only be held as members.
+struct Fixed
+{
+	uint16_t    Values[ 8 ] = {};
+	std::string Names[ 3 ];
+
+	void OnSerialise( Serialiser& a_Serialiser ) const { a_Serialiser << Values << Names; }
+	void OnDeserialise( Deserialiser& a_Deserialiser ) { a_Deserialiser >> Values >> Names; }
+	void OnSize( Sizer& a_Sizer ) const { a_Sizer + Values + Names; }
+};
+
+// Vectors written through the wrappers with encodings of their own.
+struct Wrapped
+{
+	std::vector< uint32_t > Shuffled;
+	std::vector< float >    Compressed;
+	std::vector< float >    Half;
+	std::vector< float >    Fixed;
+
+	void OnSerialise( Serialiser& a_Serialiser ) const { a_Serialiser << AsShuffled( Shuffled ) << AsXorCompressed( Compressed ) << AsHalf( Half ) << AsFixedPoint< 16 >( Fixed, -1e6f, 1e6f ); }
+	void OnDeserialise( Deserialiser& a_Deserialiser ) { a_Deserialiser >> AsShuffled( Shuffled ) >> AsXorCompressed( Compressed ) >> AsHalf( Half ) >> AsFixedPoint< 16 >( Fixed, -1e6f, 1e6f ); }
+	void OnSize( Sizer& a_Sizer ) const { a_Sizer + AsShuffled( Shuffled ) + AsXorCompressed( Compressed ) + AsHalf( Half ) + AsFixedPoint< 16 >( Fixed, -1e6f, 1e6f ); }
+};
+
+// One type per container overload of the archives, and a few nestings of them.
+using Types = std::tuple<
+	std::pair< int32_t, std::string >,
+	std::tuple< uint8_t, double, std::string >,
+	std::string,
+	std::wstring,
+	Fixed,
+	std::array< std::string, 4 >,
+	std::vector< uint32_t >,
+	std::vector< bool >,
+	std::vector< std::string >,
+	std::list< int16_t >,
+	std::forward_list< std::string >,
+	std::deque< uint64_t >,
+	std::queue< int32_t >,
+	std::priority_queue< int32_t >,
+	std::stack< std::string >,
+	std::map< int32_t, std::string >,
+	std::multimap< std::string, int32_t >,
+	std::unordered_map< uint64_t, std::vector< int32_t > >,
+	std::unordered_multimap< int32_t, int32_t >,
+	std::set< std::string >,
+	std::multiset< int32_t >,
+	std::unordered_set< uint32_t >,
+	std::unordered_multiset< std::string >,
+	std::vector< Record >,
+	std::map< std::string, std::vector< Record > >,
+	Wrapped >;
+
+static constexpr size_t TypeCount = std::tuple_size_v< Types >;
+
+// Call a_Function with a std::type_identity of the type at a_Index.
+template < typename Function >
+inline void Visit( size_t a_Index, Function&& a_Function )
+{
+	[ & ]< size_t... Index >( std::index_sequence< Index... > )
+	{
+		( ( a_Index == Index ? a_Function( std::type_identity< std::tuple_element_t< Index, Types > >() ) : void() ), ... );
+	}( std::make_index_sequence< TypeCount >() );
+}
+
+inline void Check( bool a_Condition )
+{
+	if ( !a_Condition )
+	{
+		std::abort();
+	}
+}
+
+// Decode a stream as the type, checked, and check that the result round trips.
+template < typename T >
+void TestType( std::span< const byte_t > a_Stream )
+{
+	T Value{};
+	Deserialiser deserialiser( a_Stream );
+	deserialiser >> Value;
+
+	Sizer sizer;
+	sizer + Value;
+
+	std::vector< byte_t > Encoded( sizer );
+	const std::span< byte_t > Buffer( Encoded );
+	Serialiser serialiser( Buffer );
+	serialiser << Value;
+	Check( !serialiser.HasOverflowed() && serialiser.GetBytesWritten() == Encoded.size() );
+
+	T Copy{};
+	Deserialiser Reader( Buffer );
+	Reader >> Copy;
+	Check( !Reader.HasOverflowed() && Reader.GetBytesRead() == Encoded.size() );
+}
+
+// Test a fuzzer input: a byte selecting the type, then the stream.
+inline int TestOneInput( const uint8_t* a_Data, size_t a_Size )
+{
+	if ( a_Size )
+	{
+		const std::span< const byte_t > Stream( reinterpret_cast< const byte_t* >( a_Data ) + 1u, a_Size - 1u );
+		Visit( a_Data[ 0 ] % TypeCount, [ & ]< typename T >( std::type_identity< T > ) { TestType< T >( Stream ); } );
+	}
+
+	return 0;
+}
+
+// Fills values of the fuzzed types with random content.
+class Generator
+{
+public:
+
+	Generator( uint64_t a_Seed, size_t a_MaxElements )
+		: m_Random( a_Seed )
+		, m_MaxElements( a_MaxElements )
+	{}
+
+	template < typename T >
+	void Fill( T& o_Value, size_t a_Depth = 0u )
+	{
+		if constexpr ( std::is_same_v< T, bool > )
+		{
+			o_Value = m_Random() & 1u;
+		}
+		else if constexpr ( std::is_floating_point_v< T > )
+		{
+			o_Value = static_cast< T >( std::uniform_real_distribution< double >( -1e6, 1e6 )( m_Random ) );
+		}
+		else if constexpr ( std::is_arithmetic_v< T > )
+		{
+			o_Value = static_cast< T >( m_Random() );
+		}
+		else if constexpr ( std::is_same_v< T, Record > )
+		{
+			Fill( o_Value.Id, a_Depth );
+			Fill( o_Value.Name, a_Depth + 1u );
+			Fill( o_Value.Values, a_Depth + 1u );
+		}
+		else if constexpr ( std::is_same_v< T, Fixed > )
+		{
+			Fill( o_Value.Values, a_Depth );
+			Fill( o_Value.Names, a_Depth );
+		}
+		else if constexpr ( std::is_same_v< T, Wrapped > )
+		{
+			Fill( o_Value.Shuffled, a_Depth );
+			Fill( o_Value.Compressed, a_Depth );
+			Fill( o_Value.Half, a_Depth );
+			Fill( o_Value.Fixed, a_Depth );
+		}
+		else if constexpr ( std::is_array_v< T > || requires { std::tuple_size< T >::value; } )
+		{
+			if constexpr ( std::is_array_v< T > || requires { o_Value.data(); } )
+			{
+				for ( auto& Element : o_Value )
+				{
+					Fill( Element, a_Depth + 1u );
+				}
+			}
+			else
+			{
+				std::apply( [ & ]( auto&... o_Members ) { ( Fill( o_Members, a_Depth + 1u ), ... ); }, o_Value );
+			}
+		}
+		else
+		{
+			using Element = typename T::value_type;
+			const size_t Count = m_Random() % ( m_MaxElements / ( a_Depth + 1u ) + 1u );
+
+			for ( size_t i = 0; i < Count; ++i )
+			{
+				if constexpr ( requires { typename T::mapped_type; } )
+				{
+					std::remove_const_t< typename T::key_type > Key{};
+					typename T::mapped_type Mapped{};
+					Fill( Key, a_Depth + 1u );
+					Fill( Mapped, a_Depth + 1u );
+					o_Value.emplace( std::move( Key ), std::move( Mapped ) );
+				}
+				else
+				{
+					Element Value{};
+					Fill( Value, a_Depth + 1u );
+
+					if constexpr ( requires { o_Value.push( Value ); } )
+					{
+						o_Value.push( std::move( Value ) );
+					}
+					else if constexpr ( requires { typename T::key_type; } )
+					{
+						o_Value.insert( std::move( Value ) );
+					}
+					else if constexpr ( requires { o_Value.push_back( Value ); } )
+					{
+						o_Value.push_back( std::move( Value ) );
+					}
+					else
+					{
+						o_Value.push_front( std::move( Value ) );
+					}
+				}
+			}
+		}
+	}
+
+private:
+
+	std::mt19937_64 m_Random;
+	size_t          m_MaxElements;
+};
+
+// A fuzzer input, in the format TestOneInput takes.
+struct Input
+{
+	size_t                Type;
+	std::vector< byte_t > Data;
+
+	inline std::span< const byte_t > GetStream() const { return std::span< const byte_t >( Data ).subspan( 1u ); }
+};
+
+// Serialise a_PerType random values of every type, as seed inputs for the fuzzer or a corpus for Benchmark.
+inline std::vector< Input > MakeCorpus( size_t a_PerType = 16u, size_t a_MaxElements = 256u, uint64_t a_Seed = 1u )
+{
+	std::vector< Input > Corpus;
+	Generator Random( a_Seed, a_MaxElements );
+
+	for ( size_t Type = 0; Type < TypeCount; ++Type )
+	{
+		Visit( Type, [ & ]< typename T >( std::type_identity< T > )
+		{
+			for ( size_t i = 0; i < a_PerType; ++i )
+			{
+				T Value{};
+				Random.Fill( Value );
+
+				Sizer sizer;
+				sizer + Value;
+
+				Input& Added = Corpus.emplace_back( Input{ Type, std::vector< byte_t >( static_cast< size_t >( sizer ) + 1u ) } );
+				Added.Data[ 0 ] = static_cast< byte_t >( Type );
+
+				Serialiser serialiser( Added.Data.data() + 1u );
+				serialiser << Value;
+			}
+		} );
+	}
+
+	return Corpus;
+}
+
+// Decoding throughput of one type, checked and unchecked, over the same inputs.
+struct Result
+{
+	const char* Name;
+	size_t      Bytes;
+	double      CheckedSeconds;
+	double      UncheckedSeconds;
+
+	inline double GetCheckedRate() const { return CheckedSeconds > 0.0 ? Bytes / CheckedSeconds : 0.0; }
+	inline double GetUncheckedRate() const { return UncheckedSeconds > 0.0 ? Bytes / UncheckedSeconds : 0.0; }
+};
+
+// Decode every input of the corpus a_Repetitions times, checked from a bounded span and unchecked from a raw pointer,
+// alternating between the two so that both see the same cache and clock conditions. Returns a result for each type.
+inline std::vector< Result > Benchmark( std::vector< Input >& a_Corpus, size_t a_Repetitions = 16u )
+{
+	using Clock = std::chrono::steady_clock;
+	std::vector< Result > Results;
+
+	for ( size_t Type = 0; Type < TypeCount; ++Type )
+	{
+		Visit( Type, [ & ]< typename T >( std::type_identity< T > )
+		{
+			Result& Timed = Results.emplace_back( Result{ typeid( T ).name(), 0u, 0.0, 0.0 } );
+
+			for ( size_t Repetition = 0; Repetition < a_Repetitions; ++Repetition )
+			{
+				for ( Input& Sample : a_Corpus )
+				{
+					if ( Sample.Type != Type )
+					{
+						continue;
+					}
+
+					const Clock::time_point Begin = Clock::now();
+					{
+						T Value{};
+						Deserialiser deserialiser( Sample.GetStream() );
+						deserialiser >> Value;
+					}
+					const Clock::time_point Middle = Clock::now();
+					{
+						T Value{};
+						Deserialiser deserialiser( Sample.Data.data() + 1u );
+						deserialiser >> Value;
+					}
+					const Clock::time_point End = Clock::now();
+
+					Timed.Bytes += Sample.Data.size() - 1u;
+					Timed.CheckedSeconds += std::chrono::duration< double >( Middle - Begin ).count();
+					Timed.UncheckedSeconds += std::chrono::duration< double >( End - Middle ).count();
+				}
+			}
+		} );
+	}
+
+	return Results;
+}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/FastHash.hpp>
+#include <span>
+
+//==========================================================================
+// A Hasher is a segment writer that hashes the stream written to it rather
+// than keeping it, giving a fingerprint of an object's serialised form from
+// the same OnSerialise functions, without allocating a buffer for it:
+// uint64_t Digest = Hasher::Hash64( Object );
+//
+// Whether an object changed since it was last sent is then a comparison of
+// digests rather than serialising it again and comparing bytes:
+// if ( Hasher::Hash128( Object ) != Sent ) { /* Send it. */ }
+//
+// The digest is that of the bytes a Serialiser with the same alignment
+// would write, so it matches FastHash::Hash64 of a buffer serialised from
+// the object. The stream passes through a small segment held by the hasher,
+// while bulk payloads larger than it, such as vectors of trivially copyable
+// elements, are hashed in place without being copied. A hasher may also be
+// written to directly, to hash several objects as one stream:
+// Hasher hasher;
+// Serialiser serialiser( hasher );
+// serialiser << Header << Object;
+// serialiser.Flush();
+// uint64_t Digest = hasher.Digest();
+//==========================================================================
+class Hasher : public ISegmentWriter
+{
+public:
+
+	// Size of the segment the stream passes through, small enough to stay in the L1 cache.
+	static constexpr size_t SegmentSize = 4096u;
+
+	// Given wide, a second differently seeded digest is kept for Digest128, at twice the cost.
+	Hasher( bool a_IsWide = false )
+		: m_Low( 0u )
+		, m_High( FastHash::SecondSeed )
+		, m_IsWide( a_IsWide )
+	{}
+
+	// Hash the serialised form of an object.
+	template < typename T >
+	static uint64_t Hash64( const T& a_Object, size_t a_Alignment = Serialisation::Packed )
+	{
+		Hasher hasher;
+		hasher.Add( a_Object, a_Alignment );
+		return hasher.Digest();
+	}
+
+	// Hash the serialised form of an object, to 128 bits.
+	template < typename T >
+	static FastHash::Digest128 Hash128( const T& a_Object, size_t a_Alignment = Serialisation::Packed )
+	{
+		Hasher hasher( true );
+		hasher.Add( a_Object, a_Alignment );
+		return hasher.Digest128();
+	}
+
+	// Hash the serialised form of an object on to the stream, as a stream of its own.
+	template < typename T >
+	Hasher& Add( const T& a_Object, size_t a_Alignment = Serialisation::Packed )
+	{
+		Serialiser serialiser( *this, a_Alignment );
+		serialiser << a_Object;
+		serialiser.Flush();
+		return *this;
+	}
+
+	// Start a new stream.
+	void Reset()
+	{
+		m_Low.Reset( 0u );
+		m_High.Reset( FastHash::SecondSeed );
+	}
+
+	// Get the hash of the stream so far, once flushed.
+	inline uint64_t Digest() const { return m_Low.Digest(); }
+
+	// Get the 128 bit hash of the stream so far, once flushed. The hasher must be wide.
+	inline FastHash::Digest128 Digest128() const { return { m_Low.Digest(), m_High.Digest() }; }
+
+	std::span< byte_t > GetNextSegment( size_t a_Used ) override
+	{
+		Update( m_Segment, a_Used );
+		return m_Segment;
+	}
+
+	void Commit( size_t a_Used ) override
+	{
+		Update( m_Segment, a_Used );
+	}
+
+	bool Append( size_t a_Used, const void* a_Data, size_t a_Size ) override
+	{
+		Update( m_Segment, a_Used );
+		Update( a_Data, a_Size );
+		return true;
+	}
+
+private:
+
+	inline void Update( const void* a_Data, size_t a_Size )
+	{
+		m_Low.Update( a_Data, a_Size );
+
+		if ( m_IsWide )
+		{
+			m_High.Update( a_Data, a_Size );
+		}
+	}
+
+	FastHash::State m_Low;
+	FastHash::State m_High;
+	bool            m_IsWide;
+	alignas( 64 ) byte_t m_Segment[ SegmentSize ];
+};
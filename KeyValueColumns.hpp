@@ -0,0 +1,129 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+//==========================================================================
+// Column encoding of maps whose keys and values are both trivially copyable,
+// such as std::map< int, float > or std::unordered_map< uint64_t, Pose >.
+// The default encoding writes each pair through the element functor as two
+// small copies. Here the pairs are gathered in blocks, and each block is
+// written as a column of its keys followed by a column of its values, one
+// bulk copy each:
+// a_Serialiser << AsColumns( Positions );
+// a_Deserialiser >> AsColumns( Positions );
+// a_Sizer + AsColumns( Positions );
+//
+// Loading reads each block back in two bulk copies and inserts from the
+// columns. Ordered maps are built from their sorted keys with the end as the
+// hint, so every insert is amortised constant time rather than a search of
+// the tree. Unordered maps are reserved for every element up front, so they
+// are never rehashed while loading. The encoding is not interchangeable with
+// the default one: a map must be read back with AsColumns too.
+//==========================================================================
+namespace KeyValueColumns
+{
+// Bytes of keys and values gathered per block.
+static constexpr size_t BlockSize = 16u * 1024u;
+}
+
+// Column encoding of a map of trivially copyable keys and values, such as a std::map or std::unordered_map.
+template < typename T >
+class Columns
+{
+public:
+
+	using Key = std::remove_const_t< typename T::key_type >;
+	using Mapped = typename T::mapped_type;
+
+	static_assert( std::is_trivially_copyable_v< Key > && std::is_trivially_copyable_v< Mapped >, "Only maps of trivially copyable keys and values are encoded as columns." );
+
+	// Pairs gathered per block, never less than one.
+	static constexpr size_t BlockCount = sizeof( Key ) + sizeof( Mapped ) < KeyValueColumns::BlockSize ? KeyValueColumns::BlockSize / ( sizeof( Key ) + sizeof( Mapped ) ) : 1u;
+
+	Columns( T& a_Value )
+		: m_Value( a_Value )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		const size_t Size = m_Value.size();
+		a_Serialiser.SerialiseAsMemory( &Size, sizeof( Size ) );
+
+		byte_t Keys[ BlockCount * sizeof( Key ) ];
+		byte_t Values[ BlockCount * sizeof( Mapped ) ];
+		auto Pair = m_Value.begin();
+
+		for ( size_t i = 0; i < Size; i += BlockCount )
+		{
+			const size_t Count = Size - i < BlockCount ? Size - i : BlockCount;
+
+			for ( size_t j = 0; j < Count; ++j, ++Pair )
+			{
+				memcpy( Keys + j * sizeof( Key ), &Pair->first, sizeof( Key ) );
+				memcpy( Values + j * sizeof( Mapped ), &Pair->second, sizeof( Mapped ) );
+			}
+
+			a_Serialiser.SerialiseAsMemory( Keys, Count * sizeof( Key ) );
+			a_Serialiser.SerialiseAsMemory( Values, Count * sizeof( Mapped ) );
+		}
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		size_t Size;
+		a_Deserialiser.ReadSize( Size );
+
+		m_Value.clear();
+		ReadBlocks( a_Deserialiser, Size );
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		a_Sizer.AddSizeOfMemory( sizeof( size_t ) + ( sizeof( Key ) + sizeof( Mapped ) ) * m_Value.size() );
+	}
+
+	// Read the blocks of a_Size pairs following the count into the map.
+	void ReadBlocks( Deserialiser& a_Deserialiser, size_t a_Size ) const
+	{
+		if constexpr ( requires { m_Value.reserve( a_Size ); } )
+		{
+			m_Value.reserve( a_Size );
+		}
+
+		byte_t Keys[ BlockCount * sizeof( Key ) ];
+		byte_t Values[ BlockCount * sizeof( Mapped ) ];
+
+		for ( size_t i = 0; i < a_Size && !a_Deserialiser.HasOverflowed(); i += BlockCount )
+		{
+			const size_t Count = a_Size - i < BlockCount ? a_Size - i : BlockCount;
+			a_Deserialiser.DeserialiseAsMemory( Keys, Count * sizeof( Key ) );
+			a_Deserialiser.DeserialiseAsMemory( Values, Count * sizeof( Mapped ) );
+
+			for ( size_t j = 0; j < Count; ++j )
+			{
+				Key Read;
+				Mapped Value;
+				memcpy( &Read, Keys + j * sizeof( Key ), sizeof( Key ) );
+				memcpy( &Value, Values + j * sizeof( Mapped ), sizeof( Mapped ) );
+
+				if constexpr ( requires { typename T::key_compare; } )
+				{
+					m_Value.emplace_hint( m_Value.end(), Read, Value );
+				}
+				else
+				{
+					m_Value.emplace( Read, Value );
+				}
+			}
+		}
+	}
+
+private:
+
+	T& m_Value;
+};
+
+template < typename T >
+inline Columns< T > AsColumns( T& a_Value ) { return { a_Value }; }
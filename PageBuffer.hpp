@@ -0,0 +1,268 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <utility>
+
+#if defined( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#elif defined( __linux__ )
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//==========================================================================
+// Page level allocation for multi-GB archives. A PageBuffer can be backed by
+// huge pages, to cut TLB misses when streaming through it, and bound to a
+// NUMA node, so that a worker decoding a slice of it reads local memory:
+// PageBuffer Buffer( Size, { PageBuffer::Huge, Node } );
+// Serialiser serialiser( Buffer.GetSpan() );
+//
+// Huge pages are either transparent ( madvise( MADV_HUGEPAGE ) ) or explicit
+// ( MAP_HUGETLB, or MEM_LARGE_PAGES on Windows ), falling back to transparent
+// and then regular pages when the system has none reserved. Node binding
+// uses the mbind system call directly, so libnuma is not needed, and is
+// skipped where unsupported; pages are then placed on first touch.
+//==========================================================================
+class PageBuffer
+{
+public:
+
+	enum Pages
+	{
+		Regular,
+		Huge,
+		ExplicitHuge,
+	};
+
+	// Any NUMA node.
+	static constexpr int AnyNode = -1;
+
+	// Size of huge pages where it cannot be queried.
+	static constexpr size_t HugePageSize = 2u * 1024u * 1024u;
+
+	struct Policy
+	{
+		PageBuffer::Pages Pages = Regular;
+		int               Node = AnyNode;
+	};
+
+	PageBuffer()
+		: m_Data( nullptr )
+		, m_Size( 0u )
+		, m_Mapping( nullptr )
+		, m_MappingSize( 0u )
+	{}
+
+	PageBuffer( size_t a_Size, Policy a_Policy )
+		: PageBuffer()
+	{
+		if ( a_Size )
+		{
+			Allocate( a_Size, a_Policy );
+		}
+	}
+
+	PageBuffer( size_t a_Size )
+		: PageBuffer( a_Size, Policy() )
+	{}
+
+	PageBuffer( PageBuffer&& a_Other ) noexcept
+		: m_Data( std::exchange( a_Other.m_Data, nullptr ) )
+		, m_Size( std::exchange( a_Other.m_Size, 0u ) )
+		, m_Mapping( std::exchange( a_Other.m_Mapping, nullptr ) )
+		, m_MappingSize( std::exchange( a_Other.m_MappingSize, 0u ) )
+	{}
+
+	PageBuffer& operator=( PageBuffer&& a_Other ) noexcept
+	{
+		if ( this != &a_Other )
+		{
+			Free();
+			m_Data = std::exchange( a_Other.m_Data, nullptr );
+			m_Size = std::exchange( a_Other.m_Size, 0u );
+			m_Mapping = std::exchange( a_Other.m_Mapping, nullptr );
+			m_MappingSize = std::exchange( a_Other.m_MappingSize, 0u );
+		}
+
+		return *this;
+	}
+
+	PageBuffer( const PageBuffer& ) = delete;
+	PageBuffer& operator=( const PageBuffer& ) = delete;
+
+	~PageBuffer() { Free(); }
+
+	// Get the start of the buffer. Null if the allocation failed.
+	inline byte_t* GetData() const { return m_Data; }
+
+	// Get the size of the buffer, as requested.
+	inline size_t GetSize() const { return m_Size; }
+
+	inline std::span< byte_t > GetSpan() const { return { m_Data, m_Size }; }
+
+	// Bind the pages of a range of the buffer to a NUMA node, e.g. the slice a worker on that node will read or write.
+	// The range is widened to whole pages. Returns whether the binding was applied.
+	bool BindToNode( size_t a_Offset, size_t a_Size, int a_Node )
+	{
+		return BindToNode( m_Data + a_Offset, a_Size, a_Node );
+	}
+
+	// Bind the pages spanning a range of memory to a NUMA node. Returns whether the binding was applied.
+	static bool BindToNode( void* a_Data, size_t a_Size, int a_Node )
+	{
+#if defined( __linux__ ) && defined( SYS_mbind )
+		if ( a_Node < 0 || !a_Size )
+		{
+			return false;
+		}
+
+		const size_t PageSize = static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+		const uintptr_t Begin = reinterpret_cast< uintptr_t >( a_Data ) & ~( PageSize - 1u );
+		const uintptr_t End = ( reinterpret_cast< uintptr_t >( a_Data ) + a_Size + PageSize - 1u ) & ~( PageSize - 1u );
+
+		constexpr size_t Bits = sizeof( unsigned long ) * 8u;
+		unsigned long Mask[ 16 ] = {};
+
+		if ( static_cast< size_t >( a_Node ) >= Bits * 16u )
+		{
+			return false;
+		}
+
+		// MPOL_BIND, moving any pages already touched.
+		Mask[ a_Node / Bits ] = 1ul << ( a_Node % Bits );
+		return syscall( SYS_mbind, Begin, End - Begin, 2, Mask, Bits * 16u, 1u << 1u ) == 0;
+#else
+		( void )a_Data;
+		( void )a_Size;
+		( void )a_Node;
+		return false;
+#endif
+	}
+
+private:
+
+	void Allocate( size_t a_Size, Policy a_Policy )
+	{
+#if defined( _WIN32 )
+		const HANDLE Process = GetCurrentProcess();
+		const DWORD Type = MEM_RESERVE | MEM_COMMIT;
+		void* Data = nullptr;
+
+		if ( a_Policy.Pages == ExplicitHuge )
+		{
+			if ( const size_t LargePage = GetLargePageMinimum() )
+			{
+				m_MappingSize = ( a_Size + LargePage - 1u ) / LargePage * LargePage;
+				Data = a_Policy.Node == AnyNode ?
+					VirtualAlloc( nullptr, m_MappingSize, Type | MEM_LARGE_PAGES, PAGE_READWRITE ) :
+					VirtualAllocExNuma( Process, nullptr, m_MappingSize, Type | MEM_LARGE_PAGES, PAGE_READWRITE, static_cast< DWORD >( a_Policy.Node ) );
+			}
+		}
+
+		// Windows has no transparent huge pages, so anything else is backed by regular pages.
+		if ( !Data )
+		{
+			m_MappingSize = a_Size;
+			Data = a_Policy.Node == AnyNode ?
+				VirtualAlloc( nullptr, m_MappingSize, Type, PAGE_READWRITE ) :
+				VirtualAllocExNuma( Process, nullptr, m_MappingSize, Type, PAGE_READWRITE, static_cast< DWORD >( a_Policy.Node ) );
+		}
+
+		m_Mapping = Data;
+		m_Data = static_cast< byte_t* >( Data );
+#elif defined( __linux__ )
+		void* Data = MAP_FAILED;
+
+#if defined( MAP_HUGETLB )
+		if ( a_Policy.Pages == ExplicitHuge )
+		{
+			m_MappingSize = ( a_Size + HugePageSize - 1u ) / HugePageSize * HugePageSize;
+			Data = mmap( nullptr, m_MappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+		}
+#endif
+
+		if ( Data == MAP_FAILED && a_Policy.Pages != Regular )
+		{
+			// Over-allocate to align the buffer to a huge page, so that all of it can be promoted, then trim the excess.
+			const size_t Size = ( a_Size + HugePageSize - 1u ) / HugePageSize * HugePageSize;
+			void* Mapping = mmap( nullptr, Size + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+			if ( Mapping != MAP_FAILED )
+			{
+				const uintptr_t Begin = reinterpret_cast< uintptr_t >( Mapping );
+				const uintptr_t Aligned = ( Begin + HugePageSize - 1u ) & ~( HugePageSize - 1u );
+
+				if ( Aligned != Begin )
+				{
+					munmap( Mapping, Aligned - Begin );
+				}
+
+				if ( Begin + HugePageSize != Aligned )
+				{
+					munmap( reinterpret_cast< void* >( Aligned + Size ), Begin + HugePageSize - Aligned );
+				}
+
+				Data = reinterpret_cast< void* >( Aligned );
+				m_MappingSize = Size;
+
+#if defined( MADV_HUGEPAGE )
+				madvise( Data, Size, MADV_HUGEPAGE );
+#endif
+			}
+		}
+
+		if ( Data == MAP_FAILED )
+		{
+			m_MappingSize = a_Size;
+			Data = mmap( nullptr, m_MappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		}
+
+		if ( Data != MAP_FAILED )
+		{
+			m_Mapping = Data;
+			m_Data = static_cast< byte_t* >( Data );
+			BindToNode( Data, m_MappingSize, a_Policy.Node );
+		}
+#else
+		( void )a_Policy;
+		m_MappingSize = a_Size;
+		m_Mapping = ::operator new[]( a_Size, std::align_val_t( HugePageSize ), std::nothrow );
+		m_Data = static_cast< byte_t* >( m_Mapping );
+#endif
+
+		m_Size = m_Data ? a_Size : 0u;
+	}
+
+	void Free()
+	{
+		if ( m_Mapping )
+		{
+#if defined( _WIN32 )
+			VirtualFree( m_Mapping, 0, MEM_RELEASE );
+#elif defined( __linux__ )
+			munmap( m_Mapping, m_MappingSize );
+#else
+			::operator delete[]( m_Mapping, std::align_val_t( HugePageSize ) );
+#endif
+		}
+
+		m_Data = nullptr;
+		m_Size = 0u;
+		m_Mapping = nullptr;
+		m_MappingSize = 0u;
+	}
+
+	byte_t* m_Data;
+	size_t  m_Size;
+	void*   m_Mapping;
+	size_t  m_MappingSize;
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/KeyValueColumns.hpp>
+#include <Utils/TaskSerialisation.hpp>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+//==========================================================================
+// Parallel loading of large unordered maps of trivially copyable keys and
+// values, from the column encoding of AsColumns. Inserting tens of millions
+// of pairs one at a time misses the cache on the bucket array at every
+// insert. Here the columns are decoded and every key hashed to its bucket
+// on a TaskPool, then the pairs are partitioned by bucket range, so that
+// the inserts, which std::unordered_map only allows from one thread, sweep
+// the bucket array in order rather than at random:
+// TaskPool Pool;
+// a_Serialiser << AsParallelLoad( Index, Pool );
+// a_Deserialiser >> AsParallelLoad( Index, Pool );
+//
+// The stream is the one AsColumns writes, so either can read the other's.
+// The map is reserved for every pair before hashing, so its bucket count is
+// final. Partitioning is stable, so equal keys of a multimap keep their
+// order. Maps below ParallelThreshold pairs are loaded as by AsColumns.
+//==========================================================================
+
+// Column encoding of an unordered map of trivially copyable keys and values, loaded in parallel.
+template < typename T >
+class ParallelLoad
+{
+public:
+
+	using Key = typename Columns< T >::Key;
+	using Mapped = typename Columns< T >::Mapped;
+
+	static_assert( requires { typename T::hasher; }, "Only unordered maps are loaded in parallel." );
+
+	// Fewest pairs loaded in parallel.
+	static constexpr size_t ParallelThreshold = 64u * 1024u;
+
+	// Most bucket ranges the pairs are partitioned into.
+	static constexpr size_t MaxRegions = 4096u;
+
+	ParallelLoad( T& a_Value, TaskPool& a_Pool )
+		: m_Value( a_Value )
+		, m_Pool( a_Pool )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		Columns< T >( m_Value ).OnSerialise( a_Serialiser );
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		Columns< T >( m_Value ).OnSize( a_Sizer );
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		using Pair = std::pair< Key, Mapped >;
+		constexpr size_t BlockCount = Columns< T >::BlockCount;
+		constexpr size_t PairSize = sizeof( Key ) + sizeof( Mapped );
+
+		size_t Size;
+		a_Deserialiser.ReadSize( Size );
+
+		m_Value.clear();
+
+		if ( Size < ParallelThreshold )
+		{
+			Columns< T >( m_Value ).ReadBlocks( a_Deserialiser, Size );
+			return;
+		}
+
+		std::vector< byte_t > Payload( Size * PairSize );
+		a_Deserialiser.DeserialiseAsMemory( Payload.data(), Payload.size() );
+
+		if ( a_Deserialiser.HasOverflowed() )
+		{
+			return;
+		}
+
+		m_Value.reserve( Size );
+
+		const size_t BucketCount = m_Value.bucket_count();
+		const size_t Regions = BucketCount < MaxRegions ? BucketCount : MaxRegions;
+		const size_t Blocks = ( Size + BlockCount - 1u ) / BlockCount;
+		const size_t Chunks = ( m_Pool.GetThreadCount() + 1u ) * 4u < Blocks ? ( m_Pool.GetThreadCount() + 1u ) * 4u : Blocks;
+		const size_t ChunkBlocks = ( Blocks + Chunks - 1u ) / Chunks;
+
+		// Get the region of each pair, counting the pairs of each region within each chunk of blocks.
+		std::vector< uint32_t > PairRegions( Size );
+		std::vector< size_t > Counts( Chunks * Regions, 0u );
+
+		const auto ForEachPair = [ & ]( size_t a_Chunk, auto&& a_Function )
+		{
+			const size_t End = ( a_Chunk + 1u ) * ChunkBlocks < Blocks ? ( a_Chunk + 1u ) * ChunkBlocks : Blocks;
+
+			for ( size_t b = a_Chunk * ChunkBlocks; b < End; ++b )
+			{
+				const size_t First = b * BlockCount;
+				const size_t Count = Size - First < BlockCount ? Size - First : BlockCount;
+				const byte_t* Keys = Payload.data() + First * PairSize;
+				const byte_t* Values = Keys + Count * sizeof( Key );
+
+				for ( size_t j = 0; j < Count; ++j )
+				{
+					a_Function( First + j, Keys + j * sizeof( Key ), Values + j * sizeof( Mapped ) );
+				}
+			}
+		};
+
+		m_Pool.ParallelFor( Chunks, 1u, [ & ]( size_t a_Begin, size_t a_End )
+		{
+			const typename T::hasher Hash = m_Value.hash_function();
+
+			for ( size_t c = a_Begin; c < a_End; ++c )
+			{
+				size_t* ChunkCounts = Counts.data() + c * Regions;
+
+				ForEachPair( c, [ & ]( size_t a_Index, const byte_t* a_Key, const byte_t* )
+				{
+					Key Read;
+					memcpy( &Read, a_Key, sizeof( Key ) );
+
+					// Buckets are the hash modulo the bucket count in the common implementations, and regions are runs of neighbouring buckets.
+					const size_t Bucket = Hash( Read ) % BucketCount;
+					const uint32_t Region = static_cast< uint32_t >( static_cast< uint64_t >( Bucket ) * Regions / BucketCount );
+					PairRegions[ a_Index ] = Region;
+					++ChunkCounts[ Region ];
+				} );
+			}
+		} );
+
+		// Turn the counts into the position of each chunk's pairs within each region, regions first.
+		size_t Offset = 0u;
+
+		for ( size_t r = 0; r < Regions; ++r )
+		{
+			for ( size_t c = 0; c < Chunks; ++c )
+			{
+				const size_t Count = Counts[ c * Regions + r ];
+				Counts[ c * Regions + r ] = Offset;
+				Offset += Count;
+			}
+		}
+
+		// Scatter the pairs to their regions, in order within each.
+		std::vector< Pair > Sorted( Size );
+
+		m_Pool.ParallelFor( Chunks, 1u, [ & ]( size_t a_Begin, size_t a_End )
+		{
+			for ( size_t c = a_Begin; c < a_End; ++c )
+			{
+				size_t* ChunkOffsets = Counts.data() + c * Regions;
+
+				ForEachPair( c, [ & ]( size_t a_Index, const byte_t* a_Key, const byte_t* a_Mapped )
+				{
+					Pair& Target = Sorted[ ChunkOffsets[ PairRegions[ a_Index ] ]++ ];
+					memcpy( &Target.first, a_Key, sizeof( Key ) );
+					memcpy( &Target.second, a_Mapped, sizeof( Mapped ) );
+				} );
+			}
+		} );
+
+		Payload = {};
+		PairRegions = {};
+
+		for ( const Pair& Inserted : Sorted )
+		{
+			m_Value.emplace( Inserted.first, Inserted.second );
+		}
+	}
+
+private:
+
+	T&        m_Value;
+	TaskPool& m_Pool;
+};
+
+template < typename T >
+inline ParallelLoad< T > AsParallelLoad( T& a_Value, TaskPool& a_Pool ) { return { a_Value, a_Pool }; }
@@ -0,0 +1,263 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/TaskSerialisation.hpp>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+//==========================================================================
+// Parallel sizing of large containers. A ParallelSizer splits a std::vector
+// or std::deque into ranges, sizes each range on a TaskPool with a Sizer of
+// its own, and adds the sum to its tally, which comes out the same as a
+// Sizer's. Anything else is sized on the calling thread:
+// TaskPool Pool;
+// ParallelSizer sizer( Pool );
+// sizer + World.Name + World.Entities;
+// Buffer.resize( sizer );
+//
+// The serialised size of every element can be kept along the way, as a
+// SizeTable of offsets of each element from the first:
+// SizeTable Table;
+// sizer.AddSizeOfContainer( World.Entities, &Table );
+//
+// A parallel serialiser can then write any range of the elements straight
+// into the buffer at its offset, without sizing them again. Elements of a
+// uniform size, such as trivially copyable ones, are sized all at once.
+//
+// Exact sizes of a stream with an alignment depend on where each element
+// starts, so in that case the elements are sized in order on the calling
+// thread, still filling in the table. Packed and upper bound sizes add up in
+// any order. Element functors are called from several threads at once.
+//==========================================================================
+
+// The serialised size of each element of a container.
+class SizeTable
+{
+public:
+
+	inline size_t GetCount() const { return m_Offsets.empty() ? 0u : m_Offsets.size() - 1u; }
+
+	// Get the offset of an element from the first element in the stream. The offset at GetCount() is the size of them all.
+	inline size_t GetOffset( size_t a_Index ) const { return m_Offsets[ a_Index ]; }
+
+	inline size_t GetSize( size_t a_Index ) const { return m_Offsets[ a_Index + 1u ] - m_Offsets[ a_Index ]; }
+
+	inline std::span< const size_t > GetOffsets() const { return m_Offsets; }
+
+private:
+
+	friend class ParallelSizer;
+
+	std::vector< size_t > m_Offsets;
+};
+
+class ParallelSizer
+{
+public:
+
+	// Fewest elements sized per task.
+	static constexpr size_t DefaultGrain = 256u;
+
+	ParallelSizer( TaskPool& a_Pool, size_t a_Alignment = Serialisation::Packed, Sizer::Mode a_Mode = Sizer::Exact, size_t a_Grain = DefaultGrain )
+		: m_Pool( a_Pool )
+		, m_Sizer( a_Alignment, a_Mode )
+		, m_Grain( a_Grain ? a_Grain : 1u )
+	{}
+
+	// Size anything other than a vector or deque on the calling thread.
+	template < typename T >
+	ParallelSizer& AddSizeOfContainer( const T& a_Container )
+	{
+		m_Sizer + a_Container;
+		return *this;
+	}
+
+	// Size the elements of the vector in parallel, optionally keeping the size of each in o_Table.
+	template < typename... T, typename Functor = Sizer::DefaultFunctor >
+		requires ( !std::is_same_v< typename std::vector< T... >::value_type, bool > )
+	ParallelSizer& AddSizeOfContainer( const std::vector< T... >& a_Container, SizeTable* o_Table = nullptr, Functor&& a_Functor = Functor{} )
+	{
+		using Element = typename std::vector< T... >::value_type;
+
+		if ( !AddSizeOfUniform< Element, Functor, true >( a_Container, o_Table ) )
+		{
+			m_Sizer.AddSizeOfMemory( sizeof( a_Container.size() ) );
+
+			if constexpr ( Serialisation::Dispatch< Element >::IsAlignedPayload )
+			{
+				m_Sizer.AlignPayload( alignof( Element ) );
+			}
+
+			AddSizeOfElements( a_Container, o_Table, a_Functor );
+		}
+
+		return *this;
+	}
+
+	// Size the elements of the deque in parallel, optionally keeping the size of each in o_Table.
+	template < typename... T, typename Functor = Sizer::DefaultFunctor >
+	ParallelSizer& AddSizeOfContainer( const std::deque< T... >& a_Container, SizeTable* o_Table = nullptr, Functor&& a_Functor = Functor{} )
+	{
+		if ( !AddSizeOfUniform< typename std::deque< T... >::value_type, Functor, false >( a_Container, o_Table ) )
+		{
+			m_Sizer.AddSizeOfMemory( sizeof( a_Container.size() ) );
+			AddSizeOfElements( a_Container, o_Table, a_Functor );
+		}
+
+		return *this;
+	}
+
+	template < typename T >
+	inline ParallelSizer& operator+( const T& a_ObjectOrContainer )
+	{
+		return AddSizeOfContainer( a_ObjectOrContainer );
+	}
+
+	// Implicit cast the tally to a size_t.
+	operator size_t () const { return m_Sizer; }
+
+	// Get the sizer holding the tally, to size with directly.
+	inline Sizer& GetSizer() { return m_Sizer; }
+
+private:
+
+	// Size a container whose elements all have the same size, known from the type: trivially copyable elements, or any
+	// with a size bound in upper bound mode. Returns false if the elements are not of a uniform size.
+	template < typename Element, typename Functor, bool IsContiguous, typename T >
+	bool AddSizeOfUniform( const T& a_Container, SizeTable* o_Table )
+	{
+		if constexpr ( std::is_same_v< std::decay_t< Functor >, Sizer::DefaultFunctor > )
+		{
+			size_t Size = 0u;
+
+			if ( m_Sizer.IsUpperBound() && ( Size = Serialisation::SizeBound< Element >::Get( m_Sizer.GetAlignment() ) ) )
+			{
+				m_Sizer + a_Container;
+			}
+			else if constexpr ( Serialisation::Dispatch< Element >::IsSizedAsMemory )
+			{
+				Size = sizeof( Element );
+				m_Sizer.AddSizeOfMemory( sizeof( a_Container.size() ) );
+
+				if constexpr ( IsContiguous && Serialisation::Dispatch< Element >::IsAlignedPayload )
+				{
+					m_Sizer.AlignPayload( alignof( Element ) );
+				}
+
+				m_Sizer.AddSizeOfMemory( Size * a_Container.size() );
+			}
+
+			if ( Size )
+			{
+				if ( o_Table )
+				{
+					o_Table->m_Offsets.resize( a_Container.size() + 1u );
+
+					for ( size_t i = 0; i < o_Table->m_Offsets.size(); ++i )
+					{
+						o_Table->m_Offsets[ i ] = i * Size;
+					}
+				}
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Size each element with a Sizer per range of them, then add up the ranges. With a table, the size of each element is
+	// kept in the slot after it, and each range then turns its slots into offsets from the sum of the ranges before it.
+	template < typename T, typename Functor >
+	void AddSizeOfElements( const T& a_Container, SizeTable* o_Table, Functor& a_Functor )
+	{
+		const size_t Count = a_Container.size();
+		size_t* Sizes = nullptr;
+
+		if ( o_Table )
+		{
+			o_Table->m_Offsets.assign( Count + 1u, 0u );
+			Sizes = o_Table->m_Offsets.data() + 1u;
+		}
+
+		if ( m_Sizer.GetAlignment() && !m_Sizer.IsUpperBound() )
+		{
+			for ( size_t i = 0; i < Count; ++i )
+			{
+				const size_t Before = m_Sizer;
+				a_Functor( m_Sizer, a_Container[ i ] );
+
+				if ( Sizes )
+				{
+					Sizes[ i ] = Sizes[ i - 1u ] + ( m_Sizer - Before );
+				}
+			}
+
+			return;
+		}
+
+		const size_t MaxRanges = ( m_Pool.GetThreadCount() + 1u ) * 4u;
+		size_t RangeSize = ( Count + MaxRanges - 1u ) / MaxRanges;
+		RangeSize = RangeSize < m_Grain ? m_Grain : RangeSize;
+		const size_t Ranges = ( Count + RangeSize - 1u ) / RangeSize;
+		const Sizer::Mode Mode = m_Sizer.IsUpperBound() ? Sizer::UpperBound : Sizer::Exact;
+
+		std::vector< size_t > Totals( Ranges );
+
+		m_Pool.ParallelFor( Ranges, 1u, [ & ]( size_t a_Begin, size_t a_End )
+		{
+			for ( size_t r = a_Begin; r < a_End; ++r )
+			{
+				Sizer Local( m_Sizer.GetAlignment(), Mode );
+				const size_t End = Count - r * RangeSize < RangeSize ? Count : ( r + 1u ) * RangeSize;
+
+				for ( size_t i = r * RangeSize; i < End; ++i )
+				{
+					const size_t Before = Local;
+					a_Functor( Local, a_Container[ i ] );
+
+					if ( Sizes )
+					{
+						Sizes[ i ] = Local - Before;
+					}
+				}
+
+				Totals[ r ] = Local;
+			}
+		} );
+
+		// Turn the totals into the offset of each range.
+		size_t Total = 0u;
+
+		for ( size_t& Range : Totals )
+		{
+			const size_t Size = Range;
+			Range = Total;
+			Total += Size;
+		}
+
+		m_Sizer.AddSizeOfMemory( Total );
+
+		if ( Sizes )
+		{
+			m_Pool.ParallelFor( Ranges, 1u, [ & ]( size_t a_Begin, size_t a_End )
+			{
+				for ( size_t r = a_Begin; r < a_End; ++r )
+				{
+					const size_t End = Count - r * RangeSize < RangeSize ? Count : ( r + 1u ) * RangeSize;
+					size_t Offset = Totals[ r ];
+
+					for ( size_t i = r * RangeSize; i < End; ++i )
+					{
+						Offset += Sizes[ i ];
+						Sizes[ i ] = Offset;
+					}
+				}
+			} );
+		}
+	}
+
+	TaskPool& m_Pool;
+	Sizer     m_Sizer;
+	size_t    m_Grain;
+};
@@ -0,0 +1,536 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/Compression.hpp>
+#include <atomic>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <thread>
+#include <vector>
+
+//==========================================================================
+// Pipelined compressed streams, in which encoding, compression and I/O all
+// overlap. A PipelineWriter hands the Serialiser fixed size blocks; each full
+// block is compressed by one of a pool of threads while the Serialiser fills
+// the next, and a writer thread emits the compressed blocks in order:
+// std::ofstream File( "World.bin", std::ios::binary );
+// PipelineWriter Writer( File );
+// Serialiser serialiser( Writer );
+// serialiser << World;
+// serialiser.Flush();
+//
+// A PipelineReader mirrors it: a reader thread reads compressed blocks ahead,
+// the pool decompresses them, and the Deserialiser consumes them in order:
+// std::ifstream File( "World.bin", std::ios::binary );
+// PipelineReader Reader( File );
+// Deserialiser deserialiser( Reader );
+// deserialiser >> World;
+//
+// Stages pass block indices over bounded lock-free queues, and a fixed pool
+// of blocks bounds the memory in flight; a stage that runs ahead waits for a
+// free block. The stream is a sequence of blocks, each a 32 bit frame size
+// followed by a Compression frame, ended by a zero size.
+//==========================================================================
+
+// A bounded multi-producer multi-consumer queue. Each cell carries a sequence number that says whether it is ready to be
+// pushed to or popped from on the current lap, so the fast paths are a single compare and swap. Push and Pop wait on the
+// cell's sequence when the queue is full or empty, which blocks in the kernel rather than spinning.
+template < typename T >
+class BoundedQueue
+{
+public:
+
+	// The capacity is rounded up to a power of two.
+	BoundedQueue( size_t a_Capacity )
+	{
+		size_t Capacity = 2u;
+
+		while ( Capacity < a_Capacity )
+		{
+			Capacity <<= 1u;
+		}
+
+		m_Cells = std::make_unique< Cell[] >( Capacity );
+		m_Mask = Capacity - 1u;
+
+		for ( size_t i = 0; i < Capacity; ++i )
+		{
+			m_Cells[ i ].Sequence.store( i, std::memory_order_relaxed );
+		}
+	}
+
+	void Push( const T& a_Value )
+	{
+		size_t Position = m_PushPosition.load( std::memory_order_relaxed );
+
+		for ( ;; )
+		{
+			Cell& Slot = m_Cells[ Position & m_Mask ];
+			const size_t Sequence = Slot.Sequence.load( std::memory_order_acquire );
+			const intptr_t Difference = static_cast< intptr_t >( Sequence ) - static_cast< intptr_t >( Position );
+
+			if ( Difference == 0 )
+			{
+				if ( m_PushPosition.compare_exchange_weak( Position, Position + 1u, std::memory_order_relaxed ) )
+				{
+					Slot.Value = a_Value;
+					Slot.Sequence.store( Position + 1u, std::memory_order_release );
+					Slot.Sequence.notify_all();
+					return;
+				}
+			}
+			else if ( Difference < 0 )
+			{
+				// Full: wait for the cell to be popped on the previous lap.
+				Slot.Sequence.wait( Sequence, std::memory_order_acquire );
+				Position = m_PushPosition.load( std::memory_order_relaxed );
+			}
+			else
+			{
+				Position = m_PushPosition.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	T Pop()
+	{
+		size_t Position = m_PopPosition.load( std::memory_order_relaxed );
+
+		for ( ;; )
+		{
+			Cell& Slot = m_Cells[ Position & m_Mask ];
+			const size_t Sequence = Slot.Sequence.load( std::memory_order_acquire );
+			const intptr_t Difference = static_cast< intptr_t >( Sequence ) - static_cast< intptr_t >( Position + 1u );
+
+			if ( Difference == 0 )
+			{
+				if ( m_PopPosition.compare_exchange_weak( Position, Position + 1u, std::memory_order_relaxed ) )
+				{
+					T Value = Slot.Value;
+					Slot.Sequence.store( Position + m_Mask + 1u, std::memory_order_release );
+					Slot.Sequence.notify_all();
+					return Value;
+				}
+			}
+			else if ( Difference < 0 )
+			{
+				// Empty: wait for the cell to be pushed on this lap.
+				Slot.Sequence.wait( Sequence, std::memory_order_acquire );
+				Position = m_PopPosition.load( std::memory_order_relaxed );
+			}
+			else
+			{
+				Position = m_PopPosition.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+private:
+
+	struct Cell
+	{
+		std::atomic< size_t > Sequence;
+		T                     Value;
+	};
+
+	// Producers and consumers contend on different lines.
+	std::unique_ptr< Cell[] >         m_Cells;
+	size_t                            m_Mask;
+	alignas( 64 ) std::atomic< size_t > m_PushPosition = 0;
+	alignas( 64 ) std::atomic< size_t > m_PopPosition = 0;
+};
+
+namespace Pipeline
+{
+static constexpr size_t DefaultBlockSize = 1024u * 1024u;
+
+// Largest block a reader accepts, so that a corrupt size cannot ask for an arbitrary allocation.
+static constexpr size_t MaxBlockSize = 256u * 1024u * 1024u;
+
+// Marks the end of the stream in the queues.
+static constexpr size_t End = SIZE_MAX;
+
+enum BlockState : uint32_t
+{
+	Pending,
+	Ready,
+	Failed,
+};
+
+struct Block
+{
+	std::vector< byte_t >    Raw;
+	std::vector< byte_t >    Compressed;
+	size_t                   Size = 0u;
+	std::atomic< uint32_t >  State = Pending;
+
+	// Wait for the block to leave the pending state.
+	uint32_t Wait() const
+	{
+		uint32_t Current;
+
+		while ( ( Current = State.load( std::memory_order_acquire ) ) == Pending )
+		{
+			State.wait( Pending, std::memory_order_acquire );
+		}
+
+		return Current;
+	}
+
+	void Finish( uint32_t a_State )
+	{
+		State.store( a_State, std::memory_order_release );
+		State.notify_all();
+	}
+};
+
+// Leave a core each for the thread encoding or decoding and the thread doing I/O.
+inline size_t GetDefaultThreads()
+{
+	const size_t Cores = std::thread::hardware_concurrency();
+	return Cores > 3u ? Cores - 2u : 1u;
+}
+}
+
+class PipelineWriter : public ISegmentWriter
+{
+public:
+
+	PipelineWriter( std::ostream& a_Stream, size_t a_Threads = Pipeline::GetDefaultThreads(), size_t a_BlockSize = Pipeline::DefaultBlockSize )
+		: m_Stream( a_Stream )
+		, m_Blocks( a_Threads * 2u + 2u )
+		, m_Free( m_Blocks.size() )
+		, m_Work( m_Blocks.size() + a_Threads )
+		, m_Order( m_Blocks.size() + 1u )
+		, m_Current( Pipeline::End )
+		, m_HasFailed( false )
+		, m_IsClosed( false )
+	{
+		for ( size_t i = 0; i < m_Blocks.size(); ++i )
+		{
+			m_Blocks[ i ].Raw.resize( a_BlockSize );
+			m_Blocks[ i ].Compressed.resize( Compression::GetCompressBound( a_BlockSize ) );
+			m_Free.Push( i );
+		}
+
+		for ( size_t i = 0; i < ( a_Threads ? a_Threads : 1u ); ++i )
+		{
+			m_Compressors.emplace_back( [ this ]() { Compress(); } );
+		}
+
+		m_Writer = std::thread( [ this ]() { Write(); } );
+	}
+
+	~PipelineWriter() { Close(); }
+
+	PipelineWriter( const PipelineWriter& ) = delete;
+	PipelineWriter& operator=( const PipelineWriter& ) = delete;
+
+	// Get whether writing to the stream failed. Complete once the Serialiser is flushed.
+	inline bool HasFailed() const { return m_HasFailed.load( std::memory_order_acquire ); }
+
+private:
+
+	std::span< byte_t > GetNextSegment( size_t a_Used ) override
+	{
+		if ( m_IsClosed )
+		{
+			return {};
+		}
+
+		Submit( a_Used );
+		m_Current = m_Free.Pop();
+		return m_Blocks[ m_Current ].Raw;
+	}
+
+	// Submit the last block and wait for every block to be written.
+	void Commit( size_t a_Used ) override
+	{
+		Submit( a_Used );
+		Close();
+	}
+
+	void Submit( size_t a_Used )
+	{
+		if ( m_Current == Pipeline::End )
+		{
+			return;
+		}
+
+		if ( a_Used )
+		{
+			Pipeline::Block& Current = m_Blocks[ m_Current ];
+			Current.Size = a_Used;
+			Current.State.store( Pipeline::Pending, std::memory_order_relaxed );
+			m_Order.Push( m_Current );
+			m_Work.Push( m_Current );
+		}
+		else
+		{
+			m_Free.Push( m_Current );
+		}
+
+		m_Current = Pipeline::End;
+	}
+
+	void Close()
+	{
+		if ( m_IsClosed )
+		{
+			return;
+		}
+
+		m_IsClosed = true;
+		m_Order.Push( Pipeline::End );
+
+		for ( size_t i = 0; i < m_Compressors.size(); ++i )
+		{
+			m_Work.Push( Pipeline::End );
+		}
+
+		for ( std::thread& Compressor : m_Compressors )
+		{
+			Compressor.join();
+		}
+
+		m_Writer.join();
+	}
+
+	void Compress()
+	{
+		for ( size_t Index; ( Index = m_Work.Pop() ) != Pipeline::End; )
+		{
+			Pipeline::Block& Current = m_Blocks[ Index ];
+			const size_t Size = Compression::Compress( std::span< const byte_t >( Current.Raw.data(), Current.Size ), Current.Compressed );
+			Current.Size = Size;
+			Current.Finish( Size ? Pipeline::Ready : Pipeline::Failed );
+		}
+	}
+
+	void Write()
+	{
+		for ( size_t Index; ( Index = m_Order.Pop() ) != Pipeline::End; )
+		{
+			Pipeline::Block& Current = m_Blocks[ Index ];
+
+			// Keep draining after a failure, so that the other stages never wait on a free block.
+			if ( Current.Wait() != Pipeline::Ready || !WriteFrame( Current.Compressed.data(), Current.Size ) )
+			{
+				m_HasFailed.store( true, std::memory_order_release );
+			}
+
+			m_Free.Push( Index );
+		}
+
+		if ( !WriteFrame( nullptr, 0u ) || !m_Stream.flush() )
+		{
+			m_HasFailed.store( true, std::memory_order_release );
+		}
+	}
+
+	bool WriteFrame( const byte_t* a_Frame, size_t a_Size )
+	{
+		const uint32_t Size = static_cast< uint32_t >( a_Size );
+		m_Stream.write( reinterpret_cast< const char* >( &Size ), sizeof( Size ) );
+		m_Stream.write( reinterpret_cast< const char* >( a_Frame ), static_cast< std::streamsize >( a_Size ) );
+		return static_cast< bool >( m_Stream );
+	}
+
+	std::ostream&                   m_Stream;
+	std::vector< Pipeline::Block >  m_Blocks;
+	BoundedQueue< size_t >          m_Free;
+	BoundedQueue< size_t >          m_Work;
+	BoundedQueue< size_t >          m_Order;
+	std::vector< std::thread >      m_Compressors;
+	std::thread                     m_Writer;
+	size_t                          m_Current;
+	std::atomic< bool >             m_HasFailed;
+	bool                            m_IsClosed;
+};
+
+class PipelineReader : public ISegmentReader
+{
+public:
+
+	PipelineReader( std::istream& a_Stream, size_t a_Threads = Pipeline::GetDefaultThreads() )
+		: m_Stream( a_Stream )
+		, m_Blocks( a_Threads * 2u + 2u )
+		, m_Free( m_Blocks.size() )
+		, m_Work( m_Blocks.size() + a_Threads )
+		, m_Order( m_Blocks.size() + 1u )
+		, m_Current( Pipeline::End )
+		, m_HasFailed( false )
+		, m_HasEnded( false )
+		, m_IsCorrupt( false )
+		, m_Stop( false )
+	{
+		for ( size_t i = 0; i < m_Blocks.size(); ++i )
+		{
+			m_Free.Push( i );
+		}
+
+		for ( size_t i = 0; i < ( a_Threads ? a_Threads : 1u ); ++i )
+		{
+			m_Decompressors.emplace_back( [ this ]() { Decompress(); } );
+		}
+
+		m_Reader = std::thread( [ this ]() { Read(); } );
+	}
+
+	// Stop reading ahead, and drain whatever is in flight.
+	~PipelineReader()
+	{
+		m_Stop.store( true, std::memory_order_release );
+
+		if ( m_Current != Pipeline::End )
+		{
+			m_Free.Push( m_Current );
+		}
+
+		for ( size_t Index; !m_HasEnded; )
+		{
+			if ( ( Index = m_Order.Pop() ) == Pipeline::End )
+			{
+				m_HasEnded = true;
+			}
+			else
+			{
+				m_Blocks[ Index ].Wait();
+				m_Free.Push( Index );
+			}
+		}
+
+		for ( std::thread& Decompressor : m_Decompressors )
+		{
+			Decompressor.join();
+		}
+
+		m_Reader.join();
+	}
+
+	PipelineReader( const PipelineReader& ) = delete;
+	PipelineReader& operator=( const PipelineReader& ) = delete;
+
+	std::span< const byte_t > GetNextSegment() override
+	{
+		if ( m_Current != Pipeline::End )
+		{
+			m_Free.Push( m_Current );
+			m_Current = Pipeline::End;
+		}
+
+		if ( m_HasEnded || m_IsCorrupt )
+		{
+			return {};
+		}
+
+		const size_t Index = m_Order.Pop();
+
+		if ( Index == Pipeline::End )
+		{
+			m_HasEnded = true;
+			return {};
+		}
+
+		Pipeline::Block& Current = m_Blocks[ Index ];
+		m_Current = Index;
+
+		// The stream ends at a corrupt block rather than skipping over it.
+		if ( Current.Wait() != Pipeline::Ready )
+		{
+			m_IsCorrupt = true;
+			m_HasFailed.store( true, std::memory_order_release );
+			return {};
+		}
+
+		return { Current.Raw.data(), Current.Size };
+	}
+
+	// Get whether the stream was truncated or a block was corrupt.
+	inline bool HasFailed() const { return m_HasFailed.load( std::memory_order_acquire ); }
+
+private:
+
+	void Decompress()
+	{
+		for ( size_t Index; ( Index = m_Work.Pop() ) != Pipeline::End; )
+		{
+			Pipeline::Block& Current = m_Blocks[ Index ];
+			Compression::FrameHeader Header;
+			bool IsValid = Compression::ReadFrameHeader( Current.Compressed, Header ) && Header.Size <= Pipeline::MaxBlockSize;
+
+			if ( IsValid )
+			{
+				Current.Raw.resize( Header.Size );
+				Current.Size = Header.Size;
+				IsValid = Compression::Decompress( Current.Compressed, Current.Raw );
+			}
+
+			Current.Finish( IsValid ? Pipeline::Ready : Pipeline::Failed );
+		}
+	}
+
+	void Read()
+	{
+		while ( !m_Stop.load( std::memory_order_acquire ) )
+		{
+			uint32_t Size = 0u;
+
+			if ( !m_Stream.read( reinterpret_cast< char* >( &Size ), sizeof( Size ) ) )
+			{
+				m_HasFailed.store( true, std::memory_order_release );
+				break;
+			}
+
+			if ( !Size )
+			{
+				break;
+			}
+
+			const size_t Index = m_Free.Pop();
+			Pipeline::Block& Current = m_Blocks[ Index ];
+
+			if ( Size > Compression::GetCompressBound( Pipeline::MaxBlockSize ) )
+			{
+				m_Free.Push( Index );
+				m_HasFailed.store( true, std::memory_order_release );
+				break;
+			}
+
+			Current.Compressed.resize( Size );
+
+			if ( !m_Stream.read( reinterpret_cast< char* >( Current.Compressed.data() ), Size ) )
+			{
+				m_Free.Push( Index );
+				m_HasFailed.store( true, std::memory_order_release );
+				break;
+			}
+
+			Current.State.store( Pipeline::Pending, std::memory_order_relaxed );
+			m_Order.Push( Index );
+			m_Work.Push( Index );
+		}
+
+		m_Order.Push( Pipeline::End );
+
+		for ( size_t i = 0; i < m_Decompressors.size(); ++i )
+		{
+			m_Work.Push( Pipeline::End );
+		}
+	}
+
+	std::istream&                   m_Stream;
+	std::vector< Pipeline::Block >  m_Blocks;
+	BoundedQueue< size_t >          m_Free;
+	BoundedQueue< size_t >          m_Work;
+	BoundedQueue< size_t >          m_Order;
+	std::vector< std::thread >      m_Decompressors;
+	std::thread                     m_Reader;
+	size_t                          m_Current;
+	std::atomic< bool >             m_HasFailed;
+	bool                            m_HasEnded;
+	bool                            m_IsCorrupt;
+	std::atomic< bool >             m_Stop;
+};
@@ -0,0 +1,576 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#include <immintrin.h>
+#define QUANTISATION_SSE2 1
+#else
+#define QUANTISATION_SSE2 0
+#endif
+
+#if defined( __F16C__ ) || ( defined( _MSC_VER ) && defined( __AVX2__ ) )
+#define QUANTISATION_F16C 1
+#else
+#define QUANTISATION_F16C 0
+#endif
+
+//==========================================================================
+// Lossy encodings for floating point fields, applied per field by wrapping
+// it in the archive expressions of its hooks:
+// void OnSerialise( Serialiser& a_Serialiser ) const
+// {
+//     a_Serialiser << AsFixedPoint< 16 >( Position, -1024.0f, 1024.0f ) << AsSmallestThree( Rotation ) << AsHalf( Speed );
+// }
+// void OnDeserialise( Deserialiser& a_Deserialiser )
+// {
+//     a_Deserialiser >> AsFixedPoint< 16 >( Position, -1024.0f, 1024.0f ) >> AsSmallestThree( Rotation ) >> AsHalf( Speed );
+// }
+// void OnSize( Sizer& a_Sizer ) const
+// {
+//     a_Sizer + AsFixedPoint< 16 >( Position, -1024.0f, 1024.0f ) + AsSmallestThree( Rotation ) + AsHalf( Speed );
+// }
+//
+// - AsFixedPoint< Bits >( Value, Min, Max ): clamps to the range and rounds
+//   to the nearest of 2^Bits evenly spaced steps, stored in 1, 2 or 4 bytes.
+// - AsHalf( Value ): IEEE 754 half precision, in 2 bytes.
+// - AsSmallestThree( Quaternion ): a unit quaternion as the index of its
+//   largest component and the other three at 10 bits each, in 4 bytes.
+//   Quaternions are indexable ( q[ 0 ] .. q[ 3 ] ) or have x, y, z and w.
+// Wrapping a std::vector of floats encodes all of its elements, with SIMD
+// kernels for fixed point and half floats.
+//==========================================================================
+namespace Quantisation
+{
+// Smallest unsigned integer holding the given number of bits.
+template < unsigned Bits >
+using Storage = std::conditional_t< ( Bits <= 8u ), uint8_t, std::conditional_t< ( Bits <= 16u ), uint16_t, uint32_t > >;
+
+// Elements encoded per chunk by batch kernels streaming through an archive.
+static constexpr size_t ChunkSize = 256u;
+
+template < unsigned Bits >
+struct FixedPointRange
+{
+	static_assert( Bits >= 1u && Bits <= 32u, "Fixed point fields are 1 to 32 bits." );
+
+	FixedPointRange( float a_Min, float a_Max )
+		: Min( a_Min )
+		, Max( a_Max )
+		, Scale( static_cast< float >( Steps / ( static_cast< double >( a_Max ) - a_Min ) ) )
+		, Step( static_cast< float >( ( static_cast< double >( a_Max ) - a_Min ) / Steps ) )
+	{}
+
+	static constexpr double Steps = static_cast< double >( ( 1ull << Bits ) - 1u );
+
+	float Min;
+	float Max;
+	float Scale;
+	float Step;
+};
+
+template < unsigned Bits >
+inline Storage< Bits > EncodeFixedPoint( float a_Value, const FixedPointRange< Bits >& a_Range )
+{
+	// Clamping this way round also maps NaN to the top of the range, matching the SIMD kernels.
+	const float Clamped = a_Value < a_Range.Max ? a_Value : a_Range.Max;
+	const float Value = Clamped > a_Range.Min ? Clamped : a_Range.Min;
+
+	if constexpr ( Bits <= 16u )
+	{
+		return static_cast< Storage< Bits > >( static_cast< int32_t >( ( Value - a_Range.Min ) * a_Range.Scale + 0.5f ) );
+	}
+	else
+	{
+		const double Steps = ( static_cast< double >( Value ) - a_Range.Min ) / ( static_cast< double >( a_Range.Max ) - a_Range.Min ) * FixedPointRange< Bits >::Steps;
+		return static_cast< Storage< Bits > >( Steps + 0.5 );
+	}
+}
+
+template < unsigned Bits >
+inline float DecodeFixedPoint( Storage< Bits > a_Value, const FixedPointRange< Bits >& a_Range )
+{
+	if constexpr ( Bits <= 16u )
+	{
+		return static_cast< float >( static_cast< int32_t >( a_Value ) ) * a_Range.Step + a_Range.Min;
+	}
+	else
+	{
+		return static_cast< float >( a_Range.Min + a_Value * ( ( static_cast< double >( a_Range.Max ) - a_Range.Min ) / FixedPointRange< Bits >::Steps ) );
+	}
+}
+
+template < unsigned Bits >
+void EncodeFixedPoint( const float* a_Values, size_t a_Count, const FixedPointRange< Bits >& a_Range, Storage< Bits >* o_Encoded )
+{
+	size_t i = 0;
+
+#if QUANTISATION_SSE2
+	if constexpr ( Bits <= 16u )
+	{
+		const __m128 Min = _mm_set1_ps( a_Range.Min );
+		const __m128 Max = _mm_set1_ps( a_Range.Max );
+		const __m128 Scale = _mm_set1_ps( a_Range.Scale );
+		const __m128 Half = _mm_set1_ps( 0.5f );
+
+		const auto Quantise = [ & ]( const float* a_Source )
+		{
+			const __m128 Value = _mm_max_ps( _mm_min_ps( _mm_loadu_ps( a_Source ), Max ), Min );
+			return _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( _mm_sub_ps( Value, Min ), Scale ), Half ) );
+		};
+
+		if constexpr ( Bits <= 8u )
+		{
+			for ( ; i + 16u <= a_Count; i += 16u )
+			{
+				const __m128i Low = _mm_packs_epi32( Quantise( a_Values + i ), Quantise( a_Values + i + 4u ) );
+				const __m128i High = _mm_packs_epi32( Quantise( a_Values + i + 8u ), Quantise( a_Values + i + 12u ) );
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( o_Encoded + i ), _mm_packus_epi16( Low, High ) );
+			}
+		}
+		else
+		{
+			// Bias into the signed range so that the saturating pack keeps all 16 bits.
+			const __m128i Bias = _mm_set1_epi32( 0x8000 );
+
+			for ( ; i + 8u <= a_Count; i += 8u )
+			{
+				const __m128i Packed = _mm_packs_epi32( _mm_sub_epi32( Quantise( a_Values + i ), Bias ), _mm_sub_epi32( Quantise( a_Values + i + 4u ), Bias ) );
+				_mm_storeu_si128( reinterpret_cast< __m128i* >( o_Encoded + i ), _mm_xor_si128( Packed, _mm_set1_epi16( static_cast< short >( 0x8000 ) ) ) );
+			}
+		}
+	}
+#endif
+
+	for ( ; i < a_Count; ++i )
+	{
+		o_Encoded[ i ] = EncodeFixedPoint( a_Values[ i ], a_Range );
+	}
+}
+
+template < unsigned Bits >
+void DecodeFixedPoint( const Storage< Bits >* a_Encoded, size_t a_Count, const FixedPointRange< Bits >& a_Range, float* o_Values )
+{
+	size_t i = 0;
+
+#if QUANTISATION_SSE2
+	if constexpr ( Bits <= 16u )
+	{
+		const __m128 Min = _mm_set1_ps( a_Range.Min );
+		const __m128 Step = _mm_set1_ps( a_Range.Step );
+		const __m128i Zero = _mm_setzero_si128();
+
+		const auto Dequantise = [ & ]( __m128i a_Value, float* o_Destination )
+		{
+			_mm_storeu_ps( o_Destination, _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( a_Value ), Step ), Min ) );
+		};
+
+		if constexpr ( Bits <= 8u )
+		{
+			for ( ; i + 16u <= a_Count; i += 16u )
+			{
+				const __m128i Bytes = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_Encoded + i ) );
+				const __m128i Low = _mm_unpacklo_epi8( Bytes, Zero );
+				const __m128i High = _mm_unpackhi_epi8( Bytes, Zero );
+				Dequantise( _mm_unpacklo_epi16( Low, Zero ), o_Values + i );
+				Dequantise( _mm_unpackhi_epi16( Low, Zero ), o_Values + i + 4u );
+				Dequantise( _mm_unpacklo_epi16( High, Zero ), o_Values + i + 8u );
+				Dequantise( _mm_unpackhi_epi16( High, Zero ), o_Values + i + 12u );
+			}
+		}
+		else
+		{
+			for ( ; i + 8u <= a_Count; i += 8u )
+			{
+				const __m128i Words = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_Encoded + i ) );
+				Dequantise( _mm_unpacklo_epi16( Words, Zero ), o_Values + i );
+				Dequantise( _mm_unpackhi_epi16( Words, Zero ), o_Values + i + 4u );
+			}
+		}
+	}
+#endif
+
+	for ( ; i < a_Count; ++i )
+	{
+		o_Values[ i ] = DecodeFixedPoint( a_Encoded[ i ], a_Range );
+	}
+}
+
+// Convert to half precision, rounding to nearest even.
+inline uint16_t EncodeHalf( float a_Value )
+{
+	uint32_t Bits;
+	memcpy( &Bits, &a_Value, sizeof( Bits ) );
+
+	const uint32_t Sign = ( Bits >> 16u ) & 0x8000u;
+	uint32_t Magnitude = Bits & 0x7FFFFFFFu;
+
+	// Infinity and NaN. As with F16C, NaN keeps the top of its payload and is made quiet.
+	if ( Magnitude >= 0x7F800000u )
+	{
+		return static_cast< uint16_t >( Sign | ( Magnitude > 0x7F800000u ? 0x7E00u | ( ( Magnitude & 0x7FFFFFu ) >> 13u ) : 0x7C00u ) );
+	}
+
+	// Too large, rounds to infinity.
+	if ( Magnitude >= 0x477FF000u )
+	{
+		return static_cast< uint16_t >( Sign | 0x7C00u );
+	}
+
+	// Subnormal in half precision. Let a float addition do the rounding.
+	if ( Magnitude < 0x38800000u )
+	{
+		float Value;
+		memcpy( &Value, &Magnitude, sizeof( Value ) );
+		Value += 0.5f;
+		memcpy( &Magnitude, &Value, sizeof( Magnitude ) );
+		return static_cast< uint16_t >( Sign | ( Magnitude - 0x3F000000u ) );
+	}
+
+	// Rebias the exponent and round the mantissa to nearest even.
+	const uint32_t Odd = ( Magnitude >> 13u ) & 1u;
+	Magnitude += ( static_cast< uint32_t >( 15 - 127 ) << 23u ) + 0xFFFu + Odd;
+	return static_cast< uint16_t >( Sign | ( Magnitude >> 13u ) );
+}
+
+inline float DecodeHalf( uint16_t a_Value )
+{
+	constexpr uint32_t Exponent = 0x7C00u << 13u;
+	uint32_t Bits = ( a_Value & 0x7FFFu ) << 13u;
+	const uint32_t Shifted = Bits & Exponent;
+	Bits += static_cast< uint32_t >( 127 - 15 ) << 23u;
+
+	float Value;
+
+	if ( Shifted == Exponent )
+	{
+		// Infinity and NaN. As with F16C, NaN is made quiet.
+		Bits += static_cast< uint32_t >( 128 - 16 ) << 23u;
+		Bits |= ( Bits & 0x7FFFFFu ) ? 0x400000u : 0u;
+		memcpy( &Value, &Bits, sizeof( Value ) );
+	}
+	else if ( Shifted == 0u )
+	{
+		// Zero and subnormals, renormalised by a float subtraction.
+		constexpr uint32_t MagicBits = 113u << 23u;
+		float Magic;
+		memcpy( &Magic, &MagicBits, sizeof( Magic ) );
+		Bits += 1u << 23u;
+		memcpy( &Value, &Bits, sizeof( Value ) );
+		Value -= Magic;
+	}
+	else
+	{
+		memcpy( &Value, &Bits, sizeof( Value ) );
+	}
+
+	return ( a_Value & 0x8000u ) ? -Value : Value;
+}
+
+inline void EncodeHalf( const float* a_Values, size_t a_Count, uint16_t* o_Encoded )
+{
+	size_t i = 0;
+
+#if QUANTISATION_F16C
+	for ( ; i + 8u <= a_Count; i += 8u )
+	{
+		_mm_storeu_si128( reinterpret_cast< __m128i* >( o_Encoded + i ), _mm256_cvtps_ph( _mm256_loadu_ps( a_Values + i ), _MM_FROUND_TO_NEAREST_INT ) );
+	}
+#endif
+
+	for ( ; i < a_Count; ++i )
+	{
+		o_Encoded[ i ] = EncodeHalf( a_Values[ i ] );
+	}
+}
+
+inline void DecodeHalf( const uint16_t* a_Encoded, size_t a_Count, float* o_Values )
+{
+	size_t i = 0;
+
+#if QUANTISATION_F16C
+	for ( ; i + 8u <= a_Count; i += 8u )
+	{
+		_mm256_storeu_ps( o_Values + i, _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_Encoded + i ) ) ) );
+	}
+#endif
+
+	for ( ; i < a_Count; ++i )
+	{
+		o_Values[ i ] = DecodeHalf( a_Encoded[ i ] );
+	}
+}
+
+// Get a component of a quaternion, indexable or with x, y, z and w members.
+template < typename T >
+inline auto& GetComponent( T& a_Quaternion, size_t a_Index )
+{
+	if constexpr ( requires { a_Quaternion[ a_Index ]; } )
+	{
+		return a_Quaternion[ a_Index ];
+	}
+	else
+	{
+		return a_Index == 0u ? a_Quaternion.x : a_Index == 1u ? a_Quaternion.y : a_Index == 2u ? a_Quaternion.z : a_Quaternion.w;
+	}
+}
+
+// Encode a unit quaternion as the index of its largest component in the top 2 bits, then the other three at 10 bits each.
+// The largest component is made positive, as q and -q are the same rotation, and is rebuilt from the others.
+template < typename T >
+inline uint32_t EncodeSmallestThree( const T& a_Quaternion )
+{
+	constexpr float Range = 0.707106781f;
+	const FixedPointRange< 10 > Component( -Range, Range );
+
+	size_t Largest = 0u;
+
+	for ( size_t i = 1u; i < 4u; ++i )
+	{
+		if ( std::fabs( static_cast< float >( GetComponent( a_Quaternion, i ) ) ) > std::fabs( static_cast< float >( GetComponent( a_Quaternion, Largest ) ) ) )
+		{
+			Largest = i;
+		}
+	}
+
+	const float Sign = GetComponent( a_Quaternion, Largest ) < 0 ? -1.0f : 1.0f;
+	uint32_t Encoded = static_cast< uint32_t >( Largest ) << 30u;
+
+	for ( size_t i = 0u, Shift = 20u; i < 4u; ++i )
+	{
+		if ( i != Largest )
+		{
+			Encoded |= static_cast< uint32_t >( EncodeFixedPoint( static_cast< float >( GetComponent( a_Quaternion, i ) ) * Sign, Component ) ) << Shift;
+			Shift -= 10u;
+		}
+	}
+
+	return Encoded;
+}
+
+template < typename T >
+inline void DecodeSmallestThree( uint32_t a_Encoded, T& o_Quaternion )
+{
+	constexpr float Range = 0.707106781f;
+	const FixedPointRange< 10 > Component( -Range, Range );
+
+	const size_t Largest = a_Encoded >> 30u;
+	float SumOfSquares = 0.0f;
+
+	for ( size_t i = 0u, Shift = 20u; i < 4u; ++i )
+	{
+		if ( i != Largest )
+		{
+			const float Value = DecodeFixedPoint( static_cast< Storage< 10 > >( ( a_Encoded >> Shift ) & 0x3FFu ), Component );
+			GetComponent( o_Quaternion, i ) = Value;
+			SumOfSquares += Value * Value;
+			Shift -= 10u;
+		}
+	}
+
+	GetComponent( o_Quaternion, Largest ) = std::sqrt( SumOfSquares < 1.0f ? 1.0f - SumOfSquares : 0.0f );
+}
+
+template < typename T >
+concept IsFloatVector = requires( T& a_Value ) { { a_Value.data() } -> std::convertible_to< const float* >; a_Value.size(); };
+}
+
+// Fixed point encoding of a float, or of every float in a std::vector.
+template < unsigned Bits, typename T >
+class FixedPoint
+{
+public:
+
+	using Stored = Quantisation::Storage< Bits >;
+
+	FixedPoint( T& a_Value, float a_Min, float a_Max )
+		: m_Value( a_Value )
+		, m_Range( a_Min, a_Max )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		if constexpr ( Quantisation::IsFloatVector< T > )
+		{
+			const size_t Size = m_Value.size();
+			a_Serialiser.SerialiseAsMemory( &Size, sizeof( Size ) );
+
+			Stored Chunk[ Quantisation::ChunkSize ];
+
+			for ( size_t i = 0; i < Size; i += Quantisation::ChunkSize )
+			{
+				const size_t Count = Size - i < Quantisation::ChunkSize ? Size - i : Quantisation::ChunkSize;
+				Quantisation::EncodeFixedPoint( m_Value.data() + i, Count, m_Range, Chunk );
+				a_Serialiser.SerialiseAsMemory( Chunk, sizeof( Stored ) * Count );
+			}
+		}
+		else
+		{
+			const Stored Value = Quantisation::EncodeFixedPoint( static_cast< float >( m_Value ), m_Range );
+			a_Serialiser.SerialiseAsMemory( &Value, sizeof( Value ) );
+		}
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		if constexpr ( Quantisation::IsFloatVector< T > )
+		{
+			size_t Size;
+			a_Deserialiser.ReadSize( Size );
+			m_Value.resize( Size );
+
+			Stored Chunk[ Quantisation::ChunkSize ];
+
+			for ( size_t i = 0; i < Size; i += Quantisation::ChunkSize )
+			{
+				const size_t Count = Size - i < Quantisation::ChunkSize ? Size - i : Quantisation::ChunkSize;
+				a_Deserialiser.DeserialiseAsMemory( Chunk, sizeof( Stored ) * Count );
+				Quantisation::DecodeFixedPoint( Chunk, Count, m_Range, m_Value.data() + i );
+			}
+		}
+		else
+		{
+			Stored Value;
+			a_Deserialiser.DeserialiseAsMemory( &Value, sizeof( Value ) );
+			m_Value = static_cast< std::remove_cvref_t< T > >( Quantisation::DecodeFixedPoint( Value, m_Range ) );
+		}
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		if constexpr ( Quantisation::IsFloatVector< T > )
+		{
+			a_Sizer.AddSizeOfMemory( sizeof( size_t ) + sizeof( Stored ) * m_Value.size() );
+		}
+		else
+		{
+			a_Sizer.AddSizeOfMemory( sizeof( Stored ) );
+		}
+	}
+
+private:
+
+	T&                                  m_Value;
+	Quantisation::FixedPointRange< Bits > m_Range;
+};
+
+// Half precision encoding of a float, or of every float in a std::vector.
+template < typename T >
+class HalfFloat
+{
+public:
+
+	HalfFloat( T& a_Value )
+		: m_Value( a_Value )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		if constexpr ( Quantisation::IsFloatVector< T > )
+		{
+			const size_t Size = m_Value.size();
+			a_Serialiser.SerialiseAsMemory( &Size, sizeof( Size ) );
+
+			uint16_t Chunk[ Quantisation::ChunkSize ];
+
+			for ( size_t i = 0; i < Size; i += Quantisation::ChunkSize )
+			{
+				const size_t Count = Size - i < Quantisation::ChunkSize ? Size - i : Quantisation::ChunkSize;
+				Quantisation::EncodeHalf( m_Value.data() + i, Count, Chunk );
+				a_Serialiser.SerialiseAsMemory( Chunk, sizeof( uint16_t ) * Count );
+			}
+		}
+		else
+		{
+			const uint16_t Value = Quantisation::EncodeHalf( static_cast< float >( m_Value ) );
+			a_Serialiser.SerialiseAsMemory( &Value, sizeof( Value ) );
+		}
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		if constexpr ( Quantisation::IsFloatVector< T > )
+		{
+			size_t Size;
+			a_Deserialiser.ReadSize( Size );
+			m_Value.resize( Size );
+
+			uint16_t Chunk[ Quantisation::ChunkSize ];
+
+			for ( size_t i = 0; i < Size; i += Quantisation::ChunkSize )
+			{
+				const size_t Count = Size - i < Quantisation::ChunkSize ? Size - i : Quantisation::ChunkSize;
+				a_Deserialiser.DeserialiseAsMemory( Chunk, sizeof( uint16_t ) * Count );
+				Quantisation::DecodeHalf( Chunk, Count, m_Value.data() + i );
+			}
+		}
+		else
+		{
+			uint16_t Value;
+			a_Deserialiser.DeserialiseAsMemory( &Value, sizeof( Value ) );
+			m_Value = static_cast< std::remove_cvref_t< T > >( Quantisation::DecodeHalf( Value ) );
+		}
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		if constexpr ( Quantisation::IsFloatVector< T > )
+		{
+			a_Sizer.AddSizeOfMemory( sizeof( size_t ) + sizeof( uint16_t ) * m_Value.size() );
+		}
+		else
+		{
+			a_Sizer.AddSizeOfMemory( sizeof( uint16_t ) );
+		}
+	}
+
+private:
+
+	T& m_Value;
+};
+
+// Smallest three encoding of a unit quaternion.
+template < typename T >
+class SmallestThree
+{
+public:
+
+	SmallestThree( T& a_Value )
+		: m_Value( a_Value )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		const uint32_t Value = Quantisation::EncodeSmallestThree( m_Value );
+		a_Serialiser.SerialiseAsMemory( &Value, sizeof( Value ) );
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		uint32_t Value;
+		a_Deserialiser.DeserialiseAsMemory( &Value, sizeof( Value ) );
+		Quantisation::DecodeSmallestThree( Value, m_Value );
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		a_Sizer.AddSizeOfMemory( sizeof( uint32_t ) );
+	}
+
+private:
+
+	T& m_Value;
+};
+
+template < unsigned Bits, typename T >
+inline FixedPoint< Bits, T > AsFixedPoint( T& a_Value, float a_Min, float a_Max ) { return { a_Value, a_Min, a_Max }; }
+
+template < typename T >
+inline HalfFloat< T > AsHalf( T& a_Value ) { return { a_Value }; }
+
+template < typename T >
+inline SmallestThree< T > AsSmallestThree( T& a_Value ) { return { a_Value }; }
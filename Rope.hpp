@@ -0,0 +1,119 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <Utils/PageBuffer.hpp>
+#include <span>
+#include <vector>
+
+//==========================================================================
+// A Rope is an output target for very large serialisations, made of fixed
+// size segments allocated as the stream grows, instead of one contiguous
+// buffer that has to be sized up front or copied as it grows. Objects may
+// straddle segments, and the Deserialiser reads them back segment by
+// segment without coalescing them:
+// Rope rope;
+//
+// Serialiser serialiser( rope );
+// serialiser << Object;
+// serialiser.Flush();
+//
+// Rope::Reader reader( rope );
+// Deserialiser deserialiser( reader );
+// deserialiser >> Object;
+//
+// Segments are page allocated, with a page policy for huge pages or NUMA binding:
+// Rope rope( Rope::DefaultSegmentSize, { PageBuffer::Huge, Node } );
+//==========================================================================
+class Rope : public ISegmentWriter
+{
+public:
+
+	// Default size of each segment, matching a huge page.
+	static constexpr size_t DefaultSegmentSize = 2u * 1024u * 1024u;
+
+	Rope( size_t a_SegmentSize = DefaultSegmentSize, PageBuffer::Policy a_Policy = {} )
+		: m_SegmentSize( a_SegmentSize )
+		, m_Policy( a_Policy )
+		, m_Size( 0u )
+		, m_IsOpen( false )
+	{}
+
+	// Reads the segments of a rope back in order.
+	class Reader : public ISegmentReader
+	{
+	public:
+
+		Reader( const Rope& a_Rope )
+			: m_Rope( a_Rope )
+			, m_Index( 0u )
+		{}
+
+		std::span< const byte_t > GetNextSegment() override
+		{
+			return m_Index < m_Rope.GetSegmentCount() ? m_Rope.GetSegment( m_Index++ ) : std::span< const byte_t >();
+		}
+
+	private:
+
+		const Rope& m_Rope;
+		size_t      m_Index;
+	};
+
+	// Get the number of bytes written to the rope.
+	inline size_t GetSize() const { return m_Size; }
+
+	// Get the number of segments in the rope.
+	inline size_t GetSegmentCount() const { return m_Segments.size(); }
+
+	// Get the written bytes of a segment.
+	inline std::span< const byte_t > GetSegment( size_t a_Index ) const { return { m_Segments[ a_Index ].Data.GetData(), m_Segments[ a_Index ].Size }; }
+
+	// Release every segment.
+	void Clear()
+	{
+		m_Segments.clear();
+		m_Size = 0u;
+		m_IsOpen = false;
+	}
+
+private:
+
+	std::span< byte_t > GetNextSegment( size_t a_Used ) override
+	{
+		Commit( a_Used );
+
+		// Out of memory puts the serialiser into counting mode.
+		PageBuffer Data( m_SegmentSize, m_Policy );
+
+		if ( !Data.GetData() )
+		{
+			return {};
+		}
+
+		m_Segments.push_back( { std::move( Data ), 0u } );
+		m_IsOpen = true;
+
+		return m_Segments.back().Data.GetSpan();
+	}
+
+	void Commit( size_t a_Used ) override
+	{
+		if ( m_IsOpen )
+		{
+			m_Segments.back().Size = a_Used;
+			m_Size += a_Used;
+			m_IsOpen = false;
+		}
+	}
+
+	struct Segment
+	{
+		PageBuffer Data;
+		size_t     Size;
+	};
+
+	std::vector< Segment > m_Segments;
+	size_t                 m_SegmentSize;
+	PageBuffer::Policy     m_Policy;
+	size_t                 m_Size;
+	bool                   m_IsOpen;
+};
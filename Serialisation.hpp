@@ -1,5 +1,15 @@
 #pragma once
-#include <Utils/FunctionTraits.hpp>
+#include <typeinfo>
+#include <span>
+#include <string_view>
+#include <Utils/StreamCopy.hpp>
+
+#ifdef SERIALISATION_TRACE
+#include <Utils/Trace.hpp>
+#else
+#define SERIALISATION_TRACE_SCOPE( Archive, Object )
+#define SERIALISATION_TRACE_SCOPE_IF( Condition, Archive, Object )
+#endif
 
 //==========================================================================
 // Serialisation framework allows objects to be serialised to and from byte
@@ -38,6 +48,17 @@
 //     }
 // }
 // 
+// Hooks are detected with requires-expressions, so they may be overloaded or
+// templated on the archive, e.g. template < typename Archive > void OnSerialise( Archive& ) const.
+// 
+// Optional static batch hooks are called once per contiguous container (C array, std::array,
+// std::vector) in place of the matching element hooks, e.g.
+// static void OnBeforeSerialiseBatch( std::span< ExampleStruct > a_Objects ). Between them, elements
+// without an OnSerialise/OnDeserialise are copied in bulk. A container given a custom element functor
+// leaves each element to the functor in full, so its batch hooks are not called.
+// 
+// Define SERIALISATION_TRACE to record the time spent in each container and hooked object (see Trace.hpp).
+// 
 // int main()
 // {
 //     Sizer sizer;
@@ -84,18 +105,38 @@ template < class, class, class, class > class unordered_set;
 template < class, class, class, class > class unordered_multiset;
 }
 
-#define DEFINE_HAS_SERIALISATION_FUNCTION( Name, Signature ) \
-template < typename T > \
-struct HasOn##Name \
-{ \
-	template < typename U > static long test( std::enable_if_t< std::is_same_v< Signature, FunctionTraits::GetSignature< decltype( &U::On##Name ) > >, int > ); \
-	template < typename U > static char test( ... ); \
-	static constexpr bool Value = sizeof( test< T >( 0 ) ) == sizeof( long ); \
-};
-
+class Serialisation;
 class Serialiser;
 class Deserialiser;
 class Sizer;
+class FlatBuilder;
+class ParallelSizer;
+class Comparer;
+
+// Supplies the buffers of a stream written across several of them. Returning an empty segment puts the Serialiser into counting mode.
+struct ISegmentWriter
+{
+	virtual ~ISegmentWriter() = default;
+
+	// Take back the current segment, of which a_Used bytes were written, and get the next one to write to.
+	virtual std::span< byte_t > GetNextSegment( size_t a_Used ) = 0;
+
+	// Take back the last segment, of which a_Used bytes were written.
+	virtual void Commit( size_t a_Used ) = 0;
+
+	// Take the a_Used bytes written to the current segment, followed by a_Size bytes of the stream given in place rather than
+	// copied into segments, after which the current segment is written again from its start. Returns false if unsupported.
+	virtual bool Append( size_t /* a_Used */, const void* /* a_Data */, size_t /* a_Size */ ) { return false; }
+};
+
+// Supplies the buffers of a stream read across several of them, in order.
+struct ISegmentReader
+{
+	virtual ~ISegmentReader() = default;
+
+	// Get the next segment of the stream, or an empty one at its end.
+	virtual std::span< const byte_t > GetNextSegment() = 0;
+};
 
 namespace SerialisationTempNameSpaceToStopConflictWithAlreadyExistingISerialisableClassInterfaceThatJesseMade
 {
@@ -104,7 +145,7 @@ struct ISerialisable
 {
 protected:
 
-	friend class Serialisation;
+	friend class ::Serialisation;
 
 	virtual void OnBeforeSerialise() {}
 	virtual void OnAfterSerialise() {}
@@ -116,7 +157,7 @@ struct IDeserialisable
 {
 protected:
 
-	friend class Serialisation;
+	friend class ::Serialisation;
 
 	virtual void OnBeforeDeserialise() {}
 	virtual void OnAfterDeserialise() {}
@@ -128,8 +169,42 @@ struct ISizeable
 {
 protected:
 
+	friend class ::Serialisation;
+
 	virtual void OnSize( Sizer& a_Sizer ) const = 0;
 };
+
+// Static counterpart of ISerialisable. Derived implements OnSerialise( Serialiser& ) const and may hide the optional hooks,
+// all of which are resolved at compile time without a vtable. Serialisation checks that Derived is the class deriving from
+// it and that it implements the hook.
+template < typename Derived >
+struct TSerialisable
+{
+protected:
+
+	friend class ::Serialisation;
+
+	using StaticSerialisable = Derived;
+
+	void OnBeforeSerialise() {}
+	void OnAfterSerialise() {}
+};
+
+// Static counterpart of IDeserialisable. Derived implements OnDeserialise( Deserialiser& ) and may hide the optional hooks,
+// all of which are resolved at compile time without a vtable. Serialisation checks that Derived is the class deriving from
+// it and that it implements the hook.
+template < typename Derived >
+struct TDeserialisable
+{
+protected:
+
+	friend class ::Serialisation;
+
+	using StaticDeserialisable = Derived;
+
+	void OnBeforeDeserialise() {}
+	void OnAfterDeserialise() {}
+};
 }
 
 class Serialisation
@@ -138,6 +213,15 @@ public:
 
 	Serialisation() = delete;
 
+	// Padding placed before bulk payloads of trivially copyable elements (vectors, arrays and strings), measured from the start of the stream.
+	// Packed writes no padding, Natural pads to the element's alignment and any larger value pads to at least that alignment.
+	enum Alignment : size_t
+	{
+		Packed = 0u,
+		Natural = 1u,
+		CacheLine = 64u,
+	};
+
 private:
 
 	struct Helpers
@@ -154,19 +238,226 @@ private:
 
 			HeapType& Heap;
 		};
+
+		// Types that the archives handle with a container overload rather than as objects.
+		template < typename T > struct IsContainer : std::false_type {};
+		template < typename T, size_t N > struct IsContainer< T[ N ] > : std::true_type {};
+		template < typename T, size_t N > struct IsContainer< std::array< T, N > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::pair< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::tuple< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::basic_string< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::vector< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::list< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::forward_list< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::deque< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::queue< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::priority_queue< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::stack< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::map< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::multimap< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::unordered_map< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::unordered_multimap< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::set< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::multiset< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::unordered_set< T... > > : std::true_type {};
+		template < typename... T > struct IsContainer< std::unordered_multiset< T... > > : std::true_type {};
+	};
+
+	// Dispatch strategy of a type, evaluated once per type and shared by every Serialise, Deserialise and SizeOf instantiation.
+	// Hooks are detected from within Serialisation so that private hooks of types befriending Serialisation are visible.
+	template < typename T >
+	struct Dispatch
+	{
+		static constexpr bool HasOnBeforeSerialise = requires( T& a_Object ) { a_Object.OnBeforeSerialise(); };
+		static constexpr bool HasOnSerialise = requires( const T& a_Object, Serialiser& a_Serialiser ) { a_Object.OnSerialise( a_Serialiser ); };
+		static constexpr bool HasOnAfterSerialise = requires( T& a_Object ) { a_Object.OnAfterSerialise(); };
+		static constexpr bool HasOnSize = requires( const T& a_Object, Sizer& a_Sizer ) { a_Object.OnSize( a_Sizer ); };
+		static constexpr bool HasOnBeforeDeserialise = requires( T& a_Object ) { a_Object.OnBeforeDeserialise(); };
+		static constexpr bool HasOnDeserialise = requires( T& a_Object, Deserialiser& a_Deserialiser ) { a_Object.OnDeserialise( a_Deserialiser ); };
+		static constexpr bool HasOnAfterDeserialise = requires( T& a_Object ) { a_Object.OnAfterDeserialise(); };
+
+		// Optional hooks used by a Sizer in upper bound mode, bounding every object of the type or a single object.
+		static constexpr bool HasStaticOnSizeBound = requires { static_cast< size_t >( T::OnSizeBound() ); };
+		static constexpr bool HasOnSizeBound = requires( const T& a_Object, Sizer& a_Sizer ) { a_Object.OnSizeBound( a_Sizer ); };
+
+		// Optional static hooks called once per contiguous container in place of the element hooks.
+		static constexpr bool HasOnBeforeSerialiseBatch = requires( std::span< T > a_Objects ) { T::OnBeforeSerialiseBatch( a_Objects ); };
+		static constexpr bool HasOnAfterSerialiseBatch = requires( std::span< T > a_Objects ) { T::OnAfterSerialiseBatch( a_Objects ); };
+		static constexpr bool HasOnBeforeDeserialiseBatch = requires( std::span< T > a_Objects ) { T::OnBeforeDeserialiseBatch( a_Objects ); };
+		static constexpr bool HasOnAfterDeserialiseBatch = requires( std::span< T > a_Objects ) { T::OnAfterDeserialiseBatch( a_Objects ); };
+
+		// The static type is known to be the dynamic type, so hooks can be called without virtual dispatch.
+		static constexpr bool IsExact = std::is_final_v< T > || !std::is_polymorphic_v< T >;
+
+		// The object is written, read or sized as its raw bytes, so a contiguous range of them can be handled in one bulk copy.
+		static constexpr bool IsMemory = std::is_trivially_copyable_v< T > && !Helpers::IsContainer< T >::value;
+		static constexpr bool IsSerialisedAsMemory = IsMemory && !HasOnSerialise
+			&& ( !HasOnBeforeSerialise || HasOnBeforeSerialiseBatch ) && ( !HasOnAfterSerialise || HasOnAfterSerialiseBatch );
+		static constexpr bool IsDeserialisedAsMemory = IsMemory && !HasOnDeserialise
+			&& ( !HasOnBeforeDeserialise || HasOnBeforeDeserialiseBatch ) && ( !HasOnAfterDeserialise || HasOnAfterDeserialiseBatch );
+		static constexpr bool IsSizedAsMemory = IsMemory && !HasOnSize;
+
+		// Containers of the type are padded to the payload alignment in every archive, whichever path their elements take.
+		static constexpr bool IsAlignedPayload = IsMemory && !HasOnSerialise && !HasOnDeserialise && !HasOnSize;
+
+		// A static interface base must be given the class deriving from it, which implements the matching hook.
+		static_assert( []
+		{
+			if constexpr ( requires { typename T::StaticSerialisable; } )
+			{
+				return std::is_base_of_v< typename T::StaticSerialisable, T > && HasOnSerialise;
+			}
+			else
+			{
+				return true;
+			}
+		}(), "TSerialisable< Derived > must be given the class deriving from it, which implements OnSerialise( Serialiser& ) const." );
+
+		static_assert( []
+		{
+			if constexpr ( requires { typename T::StaticDeserialisable; } )
+			{
+				return std::is_base_of_v< typename T::StaticDeserialisable, T > && HasOnDeserialise;
+			}
+			else
+			{
+				return true;
+			}
+		}(), "TDeserialisable< Derived > must be given the class deriving from it, which implements OnDeserialise( Deserialiser& )." );
+	};
+
+	// Resolves the dynamic type of a polymorphic object against a closed set of types.
+	template < typename... Derived >
+	struct DynamicType
+	{
+		static constexpr size_t Unknown = sizeof...( Derived );
+
+		// Get the index of the object's dynamic type within Derived, or Unknown.
+		template < typename Base >
+		static size_t IndexOf( const Base& a_Object )
+		{
+			size_t Index = 0;
+			( ( typeid( a_Object ) == typeid( Derived ) || ( ++Index, false ) ) || ... );
+			return Index;
+		}
+
+		// Invoke the visitor with the object cast to its dynamic type, or as Base if it is Unknown, along with whether that type is exact.
+		template < typename Base, typename Visitor >
+		static void Visit( Base& a_Object, size_t a_Index, Visitor&& a_Visitor )
+		{
+			size_t Index = 0;
+
+			if ( !( ( a_Index == Index++ && ( a_Visitor( static_cast< std::conditional_t< std::is_const_v< Base >, const Derived, Derived >& >( a_Object ), std::true_type{} ), true ) ) || ... ) )
+			{
+				a_Visitor( a_Object, std::false_type{} );
+			}
+		}
+	};
+
+	// Upper bound on the serialised size of every object of a type, counting padding at its worst, or 0 if the type is unbounded.
+	template < typename T >
+	struct SizeBound
+	{
+		static size_t Get( size_t )
+		{
+			if constexpr ( Dispatch< T >::HasStaticOnSizeBound )
+			{
+				return T::OnSizeBound();
+			}
+			else if constexpr ( Dispatch< T >::IsSizedAsMemory )
+			{
+				return sizeof( T );
+			}
+			else
+			{
+				return 0u;
+			}
+		}
+	};
+
+	template < typename T, size_t N >
+	struct SizeBound< T[ N ] >
+	{
+		static size_t Get( size_t a_Alignment ) { return GetSizeBoundOfContainer< T >( a_Alignment, N ); }
+	};
+
+	template < typename T, size_t N >
+	struct SizeBound< std::array< T, N > >
+	{
+		static size_t Get( size_t a_Alignment ) { return GetSizeBoundOfContainer< T >( a_Alignment, N ); }
+	};
+
+	template < typename... T >
+	struct SizeBound< std::pair< T... > >
+	{
+		static size_t Get( size_t a_Alignment ) { return GetSizeBoundOfMembers< std::remove_const_t< T >... >( a_Alignment ); }
+	};
+
+	template < typename... T >
+	struct SizeBound< std::tuple< T... > >
+	{
+		static size_t Get( size_t a_Alignment ) { return GetSizeBoundOfMembers< std::remove_const_t< T >... >( a_Alignment ); }
 	};
 
-	DEFINE_HAS_SERIALISATION_FUNCTION( BeforeSerialise, void() );
-	DEFINE_HAS_SERIALISATION_FUNCTION( Serialise, void( Serialiser& ) const );
-	DEFINE_HAS_SERIALISATION_FUNCTION( AfterSerialise, void() );
-	DEFINE_HAS_SERIALISATION_FUNCTION( Size, void( Sizer& ) const );
-	DEFINE_HAS_SERIALISATION_FUNCTION( BeforeDeserialise, void() );
-	DEFINE_HAS_SERIALISATION_FUNCTION( Deserialise, void( Deserialiser& ) );
-	DEFINE_HAS_SERIALISATION_FUNCTION( AfterDeserialise, void() );
+	// Get the bound of a container of the given number of elements of a type, including its size and padding, or 0 if the elements are unbounded.
+	template < typename T >
+	static size_t GetSizeBoundOfContainer( size_t a_Alignment, size_t a_Count )
+	{
+		const size_t Bound = SizeBound< T >::Get( a_Alignment );
+
+		if ( !Bound && a_Count )
+		{
+			return 0u;
+		}
+
+		const size_t Padding = Dispatch< T >::IsAlignedPayload && a_Alignment ? ( a_Alignment < alignof( T ) ? alignof( T ) : a_Alignment ) - 1u : 0u;
+		return sizeof( size_t ) + Padding + Bound * a_Count;
+	}
+
+	// Get the bound of a pair or tuple of the types, or 0 if any of them are unbounded.
+	template < typename... T >
+	static size_t GetSizeBoundOfMembers( size_t a_Alignment )
+	{
+		const size_t Bounds[] = { SizeBound< T >::Get( a_Alignment )..., 0u };
+		size_t Bound = 0u;
+
+		for ( size_t i = 0; i < sizeof...( T ); ++i )
+		{
+			if ( !Bounds[ i ] )
+			{
+				return 0u;
+			}
+
+			Bound += Bounds[ i ];
+		}
+
+		return Bound;
+	}
+
+	// Get the object an element of a polymorphic container refers to, looking through raw and smart pointers.
+	template < typename T >
+	static decltype( auto ) Dereference( T& a_Element )
+	{
+		if constexpr ( requires { *a_Element; } )
+		{
+			return *a_Element;
+		}
+		else
+		{
+			return ( a_Element );
+		}
+	}
+
+	// Detects an OnSerialise overloaded for, or templated on, an archive other than Serialiser.
+	template < typename T, typename Archive >
+	static constexpr bool HasOnSerialiseFor = requires( const T& a_Object, Archive& a_Archive ) { a_Object.OnSerialise( a_Archive ); };
 
 	friend class Serialiser;
 	friend class Deserialiser;
 	friend class Sizer;
+	friend class FlatBuilder;
+	friend class ParallelSizer;
+	friend class Comparer;
 
 	template < typename T >
 	static void Serialise( Serialiser& a_Serialiser, const T& a_Object );
@@ -176,6 +467,48 @@ private:
 
 	template < typename T >
 	static void SizeOf( Sizer& a_Sizer, const T& a_Object );
+
+	template < typename T, typename Functor >
+	static void SerialiseContiguous( Serialiser& a_Serialiser, const T* a_Objects, size_t a_Count, Functor& a_Functor );
+
+	template < typename T, typename Functor >
+	static void DeserialiseContiguous( Deserialiser& a_Deserialiser, T* o_Objects, size_t a_Count, Functor& a_Functor );
+
+	template < typename T, typename Functor >
+	static void SizeOfContiguous( Sizer& a_Sizer, const T* a_Objects, size_t a_Count, Functor& a_Functor );
+
+	template < typename... Derived, typename T >
+	static void SerialisePolymorphic( Serialiser& a_Serialiser, const T& a_Container );
+
+	template < typename... Derived, typename T >
+	static void DeserialisePolymorphic( Deserialiser& a_Deserialiser, T& o_Container, size_t a_Size );
+
+	template < typename... Derived, typename T >
+	static void SizeOfPolymorphic( Sizer& a_Sizer, const T& a_Container );
+
+	template < typename T, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeBeforeSerialise( const T& a_Object );
+
+	template < typename T, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeSerialise( Serialiser& a_Serialiser, const T& a_Object );
+
+	template < typename T, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeAfterSerialise( const T& a_Object );
+
+	template < typename T, typename Archive, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeSerialiseFor( Archive& a_Archive, const T& a_Object );
+
+	template < typename T, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeBeforeDeserialise( T& o_Object );
+
+	template < typename T, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeDeserialise( Deserialiser& a_Deserialiser, T& o_Object );
+
+	template < typename T, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeAfterDeserialise( T& o_Object );
+
+	template < typename T, bool IsExact = Dispatch< T >::IsExact >
+	static void InvokeSize( Sizer& a_Sizer, const T& a_Object );
 };
 
 // Given a byte stream that has been allocated beforehand, a Serialiser will automatically serialise any object given to it.
@@ -183,6 +516,14 @@ private:
 // - If a type is an STL container, serialise out the size of the container, and then serialise each element individually.
 // - If a type has implemented OnSerialise(Serialiser&) const, then this will be used to serialise the object.
 // - If none of the above, the object will be reinterpret casted into a byte stream and written out.
+// Given an alignment, bulk payloads of trivially copyable elements are padded so that they can be used in place.
+// The Sizer and Deserialiser must then be given the same alignment, and the buffer must be allocated at least that aligned.
+// Given a buffer span, writes that do not fit are counted rather than written, and the size the stream requires is reported:
+// Serialiser serialiser( std::span( Buffer ) );
+// serialiser << Object;
+// if ( serialiser.HasOverflowed() ) { Buffer.resize( serialiser.GetBytesRequired() ); /* Serialise again. */ }
+// Given a segment writer, such as a Rope, the stream continues into the next segment whenever one fills up and must be
+// flushed once complete. Objects may straddle segments.
 class Serialiser
 {
 public:
@@ -194,19 +535,83 @@ public:
 		void operator()( Serialiser& a_Serialiser, const T& a_Object ) { a_Serialiser << a_Object; }
 	};
 
-	Serialiser( byte_t* a_Data )
+	Serialiser( byte_t* a_Data, size_t a_Alignment = Serialisation::Packed )
 		: m_Data( a_Data )
 		, m_Head( a_Data )
+		, m_Capacity( SIZE_MAX )
+		, m_Base( 0u )
+		, m_Overflow( 0u )
+		, m_Segments( nullptr )
+		, m_Alignment( a_Alignment )
+		, m_StreamingThreshold( StreamCopy::DefaultThreshold )
+	{}
+
+	Serialiser( std::span< byte_t > a_Buffer, size_t a_Alignment = Serialisation::Packed )
+		: m_Data( a_Buffer.data() )
+		, m_Head( a_Buffer.data() )
+		, m_Capacity( a_Buffer.size() )
+		, m_Base( 0u )
+		, m_Overflow( 0u )
+		, m_Segments( nullptr )
+		, m_Alignment( a_Alignment )
+		, m_StreamingThreshold( StreamCopy::DefaultThreshold )
+	{}
+
+	Serialiser( ISegmentWriter& a_Segments, size_t a_Alignment = Serialisation::Packed )
+		: m_Data( nullptr )
+		, m_Head( nullptr )
+		, m_Capacity( 0u )
+		, m_Base( 0u )
+		, m_Overflow( 0u )
+		, m_Segments( &a_Segments )
+		, m_Alignment( a_Alignment )
+		, m_StreamingThreshold( StreamCopy::DefaultThreshold )
 	{}
 	
 	// Serialise the object as a byte stream.
 	Serialiser& SerialiseAsMemory( const void* a_Data, size_t a_Size )
 	{
-		memcpy( m_Head, a_Data, a_Size );
+		if ( a_Size > m_Capacity - static_cast< size_t >( m_Head - m_Data ) )
+		{
+			return WriteAcrossSegments( a_Data, a_Size );
+		}
+
+		if ( a_Size < m_StreamingThreshold )
+		{
+			memcpy( m_Head, a_Data, a_Size );
+		}
+		else
+		{
+			StreamCopy::Copy( m_Head, a_Data, a_Size );
+		}
+
 		m_Head += a_Size;
 		return *this;
 	}
 
+	// Set the size from which memory is written with non-temporal stores, bypassing the cache. Use SIZE_MAX to always use memcpy.
+	inline void SetStreamingThreshold( size_t a_Threshold ) { m_StreamingThreshold = a_Threshold; }
+
+	// Pad the stream with zeroes so that a bulk payload of elements with the given alignment starts aligned. Does nothing when packed.
+	Serialiser& AlignPayload( size_t a_Alignment )
+	{
+		if ( m_Alignment )
+		{
+			const size_t Alignment = a_Alignment < m_Alignment ? m_Alignment : a_Alignment;
+			const size_t Padding = ( Alignment - GetBytesRequired() % Alignment ) % Alignment;
+
+			if ( Padding > m_Capacity - static_cast< size_t >( m_Head - m_Data ) )
+			{
+				return WriteAcrossSegments( nullptr, Padding );
+			}
+
+			memset( m_Head, 0, Padding );
+			m_Head += Padding;
+		}
+
+		return *this;
+	}
+
 	// Attempt to serialise the object if it has implemented the OnSerialise interface. Fallback to byte stream serialisation.
 	template < typename T >
 	Serialiser& SerialiseAsObject( const T& a_Object )
@@ -227,6 +632,8 @@ public:
 	template < typename... T >
 	Serialiser& SerialiseAsContainer( const std::pair< T... >& a_Container )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		// Write out values.
 		SerialiseVariadic( a_Container, std::in_place_type< std::make_index_sequence< sizeof...( T ) > > );
 
@@ -237,6 +644,8 @@ public:
 	template < typename... T >
 	Serialiser& SerialiseAsContainer( const std::tuple< T... >& a_Container )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		// Write out values.
 		SerialiseVariadic( a_Container, std::in_place_type< std::make_index_sequence< sizeof...( T ) > > );
 
@@ -247,12 +656,15 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::basic_string< T... >& a_Container )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.length();
 
 		// Write out size.
 		SerialiseAsMemory( &Size, sizeof( Size ) );
 
 		// Write out characters.
+		AlignPayload( alignof( typename std::basic_string< T... >::value_type ) );
 		SerialiseAsMemory( a_Container.data(), sizeof( *a_Container.data() ) * a_Container.length() );
 
 		return *this;
@@ -262,16 +674,15 @@ public:
 	template < typename T, size_t N, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( T( &a_Container )[ N ], Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		size_t Size = N;
 
 		// Write out size.
 		SerialiseAsMemory( &Size, sizeof( Size ) );
 
 		// Write out each element.
-		for ( const auto& Object : a_Container )
-		{
-			a_Functor( *this, Object );
-		}
+		Serialisation::SerialiseContiguous( *this, a_Container, N, a_Functor );
 
 		return *this;
 	}
@@ -280,16 +691,15 @@ public:
 	template < typename T, size_t N, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::array< T, N >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		size_t Size = N;
 
 		// Write out size.
 		SerialiseAsMemory( &Size, sizeof( Size ) );
 
 		// Write out each element.
-		for ( const auto& Object : a_Container )
-		{
-			a_Functor( *this, Object );
-		}
+		Serialisation::SerialiseContiguous( *this, a_Container.data(), N, a_Functor );
 
 		return *this;
 	}
@@ -298,15 +708,26 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::vector< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
 		SerialiseAsMemory( &Size, sizeof( Size ) );
 
 		// Write out values.
-		for ( const auto& Object : a_Container )
+		if constexpr ( std::is_same_v< typename std::vector< T... >::value_type, bool > )
 		{
-			a_Functor( *this, Object );
+			AlignPayload( alignof( bool ) );
+
+			for ( const auto& Object : a_Container )
+			{
+				a_Functor( *this, Object );
+			}
+		}
+		else
+		{
+			Serialisation::SerialiseContiguous( *this, a_Container.data(), Size, a_Functor );
 		}
 
 		return *this;
@@ -316,6 +737,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::list< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -334,6 +757,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::forward_list< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = std::distance( a_Container.begin(), a_Container.end() );
 
 		// Write out size.
@@ -352,6 +777,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::deque< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -394,6 +821,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::map< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -412,6 +841,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::multimap< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -430,6 +861,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::unordered_map< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -448,6 +881,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::unordered_multimap< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -466,6 +901,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::set< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -484,6 +921,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::multiset< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -502,6 +941,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::unordered_set< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -520,6 +961,8 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Serialiser& SerialiseAsContainer( const std::unordered_multiset< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
 		auto Size = a_Container.size();
 
 		// Write out size.
@@ -534,6 +977,25 @@ public:
 		return *this;
 	}
 
+	// Serialise a container of polymorphic objects, or pointers to them, whose dynamic types are expected to be among Derived.
+	// Before and after hooks are run in monomorphic batches grouped by dynamic type, and each element is serialised in order
+	// through a non-virtual call. Elements of any other dynamic type fall back to virtual dispatch.
+	template < typename... Derived, typename T >
+	Serialiser& SerialiseAsPolymorphicContainer( const T& a_Container )
+	{
+		SERIALISATION_TRACE_SCOPE( *this, a_Container );
+
+		size_t Size = std::distance( std::begin( a_Container ), std::end( a_Container ) );
+
+		// Write out size.
+		SerialiseAsMemory( &Size, sizeof( Size ) );
+
+		// Write out values.
+		Serialisation::SerialisePolymorphic< Derived... >( *this, a_Container );
+
+		return *this;
+	}
+
 	// Automatically attempt to detect serialisation strategy. First try to serialise as a container, then as an object, and if those fail, as a byte stream.
 	template < typename T >
 	inline Serialiser& operator<<( const T& a_ObjectOrContainer )
@@ -541,25 +1003,99 @@ public:
 		return SerialiseAsContainer( a_ObjectOrContainer );
 	}
 
-	// Get the data pointer at the begging of the stream.
+	// Hand the last segment back to the segment writer, completing the stream. Does nothing without one.
+	void Flush()
+	{
+		if ( m_Segments )
+		{
+			m_Segments->Commit( m_Head - m_Data );
+		}
+	}
+
+	// Get the data pointer at the begging of the stream, or of the current segment.
 	inline const byte_t* GetData() const { return m_Data; }
 
 	// Get the data head at the current position of the stream.
 	inline const byte_t* GetHead() const { return m_Head; }
 
 	// Get the bytes written out so far.
-	inline size_t GetBytesWritten() const { return m_Head - m_Data; }
+	inline size_t GetBytesWritten() const { return m_Base + ( m_Head - m_Data ); }
+
+	// Get whether a write did not fit in the buffer. Writes past that point are only counted.
+	inline bool HasOverflowed() const { return m_Overflow; }
+
+	// Get the size of buffer the stream requires, including the writes that did not fit.
+	inline size_t GetBytesRequired() const { return GetBytesWritten() + m_Overflow; }
+
+	// Get the segment writer the stream is written to, or null when writing to a buffer.
+	inline ISegmentWriter* GetSegmentWriter() const { return m_Segments; }
+
+	// Get the payload alignment the stream is written with.
+	inline size_t GetAlignment() const { return m_Alignment; }
 
 private:
 
+	// Write what fits of data, or zeroes if null, moving on to the next segment as each fills up. Once out of space, count the rest
+	// of the stream instead, so that the bytes written remain a prefix of it.
+	Serialiser& WriteAcrossSegments( const void* a_Data, size_t a_Size )
+	{
+		auto* Source = static_cast< const byte_t* >( a_Data );
+
+		// Hand over a write larger than a whole segment in place, if the segment writer takes it.
+		if ( Source && m_Segments && m_Data && a_Size >= m_Capacity && !m_Overflow && m_Segments->Append( m_Head - m_Data, Source, a_Size ) )
+		{
+			m_Base += ( m_Head - m_Data ) + a_Size;
+			m_Head = m_Data;
+			return *this;
+		}
+
+		for ( ;; )
+		{
+			const size_t Available = m_Capacity - static_cast< size_t >( m_Head - m_Data );
+			const size_t Size = a_Size < Available ? a_Size : Available;
+
+			if ( Size )
+			{
+				Source ? memcpy( m_Head, Source, Size ) : memset( m_Head, 0, Size );
+				Source = Source ? Source + Size : nullptr;
+				m_Head += Size;
+				a_Size -= Size;
+			}
+
+			if ( !a_Size )
+			{
+				return *this;
+			}
+
+			const std::span< byte_t > Segment = m_Segments && !m_Overflow ? m_Segments->GetNextSegment( m_Head - m_Data ) : std::span< byte_t >();
+
+			if ( Segment.empty() )
+			{
+				m_Capacity = m_Head - m_Data;
+				m_Overflow += a_Size;
+				return *this;
+			}
+
+			m_Base += m_Head - m_Data;
+			m_Data = m_Head = Segment.data();
+			m_Capacity = Segment.size();
+		}
+	}
+
 	template < typename T, size_t... Idx >
 	void SerialiseVariadic( const T& a_Object, std::in_place_type_t< std::index_sequence< Idx... > > )
 	{
 		( ( *this << std::get< Idx >( a_Object ) ), ... );
 	}
 
-	byte_t* m_Data;
-	byte_t* m_Head;
+	byte_t*         m_Data;
+	byte_t*         m_Head;
+	size_t          m_Capacity;
+	size_t          m_Base;
+	size_t          m_Overflow;
+	ISegmentWriter* m_Segments;
+	size_t          m_Alignment;
+	size_t          m_StreamingThreshold;
 };
 
 // Given a byte stream full of serialised data, a Deserialiser will automatically deserialise any object given to it.
@@ -567,6 +1103,7 @@ private:
 // - If a type is an STL container, deserialise out the size of the container, resize the container to that size, and then desserialise each element individually.
 // - If a type has implemented OnDeserialise(Deserialiser&), then this will be used to deserialise the object.
 // - If none of the above, the object will be reinterpret casted into a byte stream and read into.
+// Given a segment reader, such as a Rope's, the stream continues into the next segment whenever one runs out, without coalescing them.
 class Deserialiser
 {
 public:
@@ -578,19 +1115,127 @@ public:
 		void operator()( Deserialiser& a_Deserialiser, T& a_Object ) { a_Deserialiser >> a_Object; }
 	};
 
-	Deserialiser( byte_t* a_Data )
+	Deserialiser( byte_t* a_Data, size_t a_Alignment = Serialisation::Packed )
 		: m_Data( a_Data )
 		, m_Head( a_Data )
+		, m_Capacity( SIZE_MAX )
+		, m_Base( 0u )
+		, m_Overflow( 0u )
+		, m_Segments( nullptr )
+		, m_Alignment( a_Alignment )
+		, m_StreamingThreshold( SIZE_MAX )
+		, m_IsChecked( false )
+		, m_HasSkippedView( false )
+	{}
+
+	// Read a buffer of known size, checked: reads past its end give zeroes, and a container claiming more elements than
+	// there are bytes left is read as empty, ending the stream. Use this for untrusted input.
+	Deserialiser( std::span< const byte_t > a_Buffer, size_t a_Alignment = Serialisation::Packed )
+		: m_Data( a_Buffer.data() )
+		, m_Head( a_Buffer.data() )
+		, m_Capacity( a_Buffer.size() )
+		, m_Base( 0u )
+		, m_Overflow( 0u )
+		, m_Segments( nullptr )
+		, m_Alignment( a_Alignment )
+		, m_StreamingThreshold( SIZE_MAX )
+		, m_IsChecked( true )
+		, m_HasSkippedView( false )
+	{}
+
+	Deserialiser( ISegmentReader& a_Segments, size_t a_Alignment = Serialisation::Packed )
+		: m_Data( nullptr )
+		, m_Head( nullptr )
+		, m_Capacity( 0u )
+		, m_Base( 0u )
+		, m_Overflow( 0u )
+		, m_Segments( &a_Segments )
+		, m_Alignment( a_Alignment )
+		, m_StreamingThreshold( SIZE_MAX )
+		, m_IsChecked( false )
+		, m_HasSkippedView( false )
 	{}
 
 	// Deserialise the object as a byte stream.
 	Deserialiser& DeserialiseAsMemory( void* o_Data, size_t a_Size )
 	{
-		memcpy( o_Data, m_Head, a_Size );
+		if ( a_Size > m_Capacity - static_cast< size_t >( m_Head - m_Data ) )
+		{
+			return ReadAcrossSegments( o_Data, a_Size );
+		}
+
+		if ( a_Size < m_StreamingThreshold )
+		{
+			memcpy( o_Data, m_Head, a_Size );
+		}
+		else
+		{
+			StreamCopy::PrefetchCopy( o_Data, m_Head, a_Size );
+		}
+
 		m_Head += a_Size;
 		return *this;
 	}
 
+	// Set the size from which memory is read with a prefetching copy. Off ( SIZE_MAX ) by default, as the hardware
+	// prefetcher keeps up with memcpy on most targets; enable it where profiling shows stalls on large reads.
+	inline void SetStreamingThreshold( size_t a_Threshold ) { m_StreamingThreshold = a_Threshold; }
+
+	// Skip the padding placed before a bulk payload of elements with the given alignment. Does nothing when packed.
+	Deserialiser& AlignPayload( size_t a_Alignment )
+	{
+		if ( m_Alignment )
+		{
+			const size_t Alignment = a_Alignment < m_Alignment ? m_Alignment : a_Alignment;
+			const size_t Padding = ( Alignment - GetBytesRead() % Alignment ) % Alignment;
+
+			if ( Padding > m_Capacity - static_cast< size_t >( m_Head - m_Data ) )
+			{
+				return ReadAcrossSegments( nullptr, Padding );
+			}
+
+			m_Head += Padding;
+		}
+
+		return *this;
+	}
+
+	// Read a vector, array or string of trivially copyable elements as a view into the stream, without copying it.
+	// With an aligned layout and a suitably aligned stream, the view is aligned for its elements.
+	// Elements straddling two segments cannot be viewed; they are skipped, the view left empty and HasSkippedView() set.
+	template < typename T >
+	Deserialiser& DeserialiseAsView( std::span< const T >& o_View )
+	{
+		return ReadView( o_View, static_cast< std::vector< T >* >( nullptr ) );
+	}
+
+	// Read as a view, copying elements straddling two segments into the scratch vector and viewing them there instead.
+	template < typename T >
+	Deserialiser& DeserialiseAsView( std::span< const T >& o_View, std::vector< T >& a_Scratch )
+	{
+		return ReadView( o_View, &a_Scratch );
+	}
+
+	// Read a string as a view into the stream, without copying it.
+	template < typename T, typename Traits >
+	Deserialiser& DeserialiseAsView( std::basic_string_view< T, Traits >& o_View )
+	{
+		std::span< const T > View;
+		DeserialiseAsView( View );
+		o_View = std::basic_string_view< T, Traits >( View.data(), View.size() );
+		return *this;
+	}
+
+	// Read a string as a view, copying one straddling two segments into the scratch vector.
+	template < typename T, typename Traits >
+	Deserialiser& DeserialiseAsView( std::basic_string_view< T, Traits >& o_View, std::vector< T >& a_Scratch )
+	{
+		std::span< const T > View;
+		DeserialiseAsView( View, a_Scratch );
+		o_View = std::basic_string_view< T, Traits >( View.data(), View.size() );
+		return *this;
+	}
+
 	// Attempt to deserialise the object if it has implemented the OnDeserialise interface. Fallback to byte stream deserialisation.
 	template < typename T >
 	Deserialiser& DeserialiseAsObject( T& o_Object )
@@ -611,6 +1256,8 @@ public:
 	template < typename... T >
 	Deserialiser& DeserialiseAsContainer( std::pair< T... >& o_Container )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		// Read in values.
 		DeserialiseVariadic( o_Container, std::in_place_type< std::make_index_sequence< sizeof...( T ) > > );
 
@@ -621,6 +1268,8 @@ public:
 	template < typename... T >
 	Deserialiser& DeserialiseAsContainer( std::tuple< T... >& o_Container )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		// Read in values.
 		DeserialiseVariadic( o_Container, std::in_place_type< std::make_index_sequence< sizeof...( T ) > > );
 
@@ -631,15 +1280,18 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::basic_string< T... >& o_Container )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::basic_string< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Resize the string to that length.
 		o_Container.resize( Size );
 
 		// Read in characters.
+		AlignPayload( alignof( typename std::basic_string< T... >::value_type ) );
 		DeserialiseAsMemory( o_Container.data(), sizeof( *o_Container.data() ) * Size );
 
 		return *this;
@@ -649,18 +1301,17 @@ public:
 	template < typename T, size_t N, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( T( &o_Container )[ N ], Functor&& a_Functor = Functor{})
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		size_t Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		Size = N < Size ? N : Size;
 
 		// Read in each element.
-		for ( size_t i = 0; i < Size; ++i )
-		{
-			a_Functor( *this, o_Container[ i ] );
-		}
+		Serialisation::DeserialiseContiguous( *this, o_Container, Size, a_Functor );
 
 		return *this;
 	}
@@ -669,18 +1320,17 @@ public:
 	template < typename T, size_t N, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::array< T, N >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		size_t Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		Size = N < Size ? N : Size;
 
 		// Read in each element.
-		for ( size_t i = 0; i < Size; ++i )
-		{
-			a_Functor( *this, o_Container[ i ] );
-		}
+		Serialisation::DeserialiseContiguous( *this, o_Container.data(), Size, a_Functor );
 
 		return *this;
 	}
@@ -689,18 +1339,31 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::vector< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::vector< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Reserve the vector.
 		o_Container.resize( Size );
 
 		// Read in values.
-		for ( size_t i = 0; i < Size; ++i )
+		if constexpr ( std::is_same_v< typename std::vector< T... >::value_type, bool > )
 		{
-			a_Functor( *this, o_Container[ i ] );
+			AlignPayload( alignof( bool ) );
+
+			for ( size_t i = 0; i < Size; ++i )
+			{
+				typename std::vector< T... >::value_type Value;
+				a_Functor( *this, Value );
+				o_Container[ i ] = Value;
+			}
+		}
+		else
+		{
+			Serialisation::DeserialiseContiguous( *this, o_Container.data(), Size, a_Functor );
 		}
 
 		return *this;
@@ -710,10 +1373,12 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::list< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::list< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -728,10 +1393,12 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::forward_list< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::forward_list< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		auto Begin = o_Container.before_begin();
@@ -749,10 +1416,12 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::deque< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::deque< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		o_Container.resize( Size );
 
@@ -793,10 +1462,12 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::map< T... >& o_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::map< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -815,10 +1486,12 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::multimap< T... >& o_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::multimap< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -837,10 +1510,12 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::unordered_map< T... >& o_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::unordered_map< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -859,10 +1534,12 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::unordered_multimap< T... >& o_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::unordered_multimap< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -881,10 +1558,12 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::set< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::set< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -901,10 +1580,12 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::multiset< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::multiset< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -921,10 +1602,12 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::unordered_set< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::unordered_set< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -941,10 +1624,12 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Deserialiser& DeserialiseAsContainer( std::unordered_multiset< T... >& o_Container, Functor&& a_Functor = Functor{} )
 	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
 		typename std::unordered_multiset< T... >::size_type Size;
 
 		// Read in size.
-		DeserialiseAsMemory( &Size, sizeof( Size ) );
+		ReadSize( Size );
 
 		// Read in values.
 		for ( size_t i = 0; i < Size; ++i )
@@ -957,6 +1642,28 @@ public:
 		return *this;
 	}
 
+	// Deserialise into a container already holding polymorphic objects, or pointers to them, whose dynamic types are expected to be among Derived.
+	// Before and after hooks are run in monomorphic batches grouped by dynamic type, and each element is deserialised in order
+	// through a non-virtual call. Elements of any other dynamic type fall back to virtual dispatch.
+	template < typename... Derived, typename T >
+	Deserialiser& DeserialiseAsPolymorphicContainer( T& o_Container )
+	{
+		SERIALISATION_TRACE_SCOPE( *this, o_Container );
+
+		size_t Size;
+
+		// Read in size.
+		ReadSize( Size );
+
+		size_t Capacity = std::distance( std::begin( o_Container ), std::end( o_Container ) );
+		Size = Capacity < Size ? Capacity : Size;
+
+		// Read in values.
+		Serialisation::DeserialisePolymorphic< Derived... >( *this, o_Container, Size );
+
+		return *this;
+	}
+
 	// Automatically attempt to detect deserialisation strategy. First try to deserialise as a container, then as an object, and if those fail, as a byte stream.
 	template < typename T >
 	inline Deserialiser& operator>>( T& o_ObjectOrContainer )
@@ -964,25 +1671,151 @@ public:
 		return DeserialiseAsContainer( o_ObjectOrContainer );
 	}
 
-	// Get the data pointer at the begging of the stream.
+	// Deserialise through a temporary that refers to the object, such as a quantised field wrapper.
+	template < typename T > requires ( !std::is_lvalue_reference_v< T > )
+	inline Deserialiser& operator>>( T&& o_Proxy )
+	{
+		return DeserialiseAsContainer( o_Proxy );
+	}
+
+	// Get the data pointer at the begging of the stream, or of the current segment.
 	inline const byte_t* GetData() const { return m_Data; }
 
 	// Get the data head at the current position of the stream.
 	inline const byte_t* GetHead() const { return m_Head; }
 
 	// Get the bytes read so far.
-	inline size_t GetBytesRead() const { return m_Head - m_Data; }
+	inline size_t GetBytesRead() const { return m_Base + ( m_Head - m_Data ); }
+
+	// Get whether a read went past the end of the segments. Bytes past the end read as zeroes.
+	inline bool HasOverflowed() const { return m_Overflow; }
+
+	// Get whether a view was left empty because its elements straddled two segments. Read such views with a scratch vector.
+	inline bool HasSkippedView() const { return m_HasSkippedView; }
+
+	// Read the element count of a container, also for wrappers with encodings of their own. When checked, a count larger than the
+	// bytes left allow cannot be genuine, so the rest of the stream is treated as missing and the count read as zero. Every element
+	// takes at least a byte, unless an encoding packs up to a_ElementsPerByte of them into one.
+	template < typename T >
+	inline void ReadSize( T& o_Size, size_t a_ElementsPerByte = 1u )
+	{
+		DeserialiseAsMemory( &o_Size, sizeof( o_Size ) );
+
+		const size_t Remaining = m_Capacity - static_cast< size_t >( m_Head - m_Data );
+
+		if ( m_IsChecked && o_Size / a_ElementsPerByte > Remaining )
+		{
+			m_Overflow += Remaining + 1u;
+			m_Capacity = m_Head - m_Data;
+			o_Size = 0u;
+		}
+	}
 
 private:
 
+	// Read the elements as a view into the stream, or into the scratch vector if given and they straddle two segments.
+	template < typename T >
+	Deserialiser& ReadView( std::span< const T >& o_View, std::vector< T >* a_Scratch )
+	{
+		static_assert( Serialisation::Dispatch< T >::IsAlignedPayload, "Only trivially copyable elements can be viewed in place." );
+
+		size_t Size;
+
+		// Read in size.
+		ReadSize( Size );
+
+		// Point at the elements.
+		AlignPayload( alignof( T ) );
+
+		if ( Size && m_Capacity == static_cast< size_t >( m_Head - m_Data ) )
+		{
+			ReadAcrossSegments( nullptr, 0u );
+		}
+
+		if ( sizeof( T ) * Size > m_Capacity - static_cast< size_t >( m_Head - m_Data ) )
+		{
+			if ( a_Scratch )
+			{
+				a_Scratch->resize( Size );
+				o_View = std::span< const T >( a_Scratch->data(), Size );
+				return ReadAcrossSegments( a_Scratch->data(), sizeof( T ) * Size );
+			}
+
+			o_View = std::span< const T >();
+			m_HasSkippedView = true;
+			return ReadAcrossSegments( nullptr, sizeof( T ) * Size );
+		}
+
+		o_View = std::span< const T >( reinterpret_cast< const T* >( m_Head ), Size );
+		m_Head += sizeof( T ) * Size;
+
+		return *this;
+	}
+
+	// Read into data, or skip if null, moving on to the next segment as each runs out. Reads past the last segment give zeroes.
+	// Given no size, moves on to the next segment only if the current one has run out.
+	Deserialiser& ReadAcrossSegments( void* o_Data, size_t a_Size )
+	{
+		auto* Destination = static_cast< byte_t* >( o_Data );
+
+		for ( ;; )
+		{
+			const size_t Available = m_Capacity - static_cast< size_t >( m_Head - m_Data );
+			const size_t Size = a_Size < Available ? a_Size : Available;
+
+			if ( Size )
+			{
+				Destination = Destination ? static_cast< byte_t* >( memcpy( Destination, m_Head, Size ) ) + Size : nullptr;
+				m_Head += Size;
+				a_Size -= Size;
+			}
+
+			if ( !a_Size && Available )
+			{
+				return *this;
+			}
+
+			const std::span< const byte_t > Segment = m_Segments && !m_Overflow ? m_Segments->GetNextSegment() : std::span< const byte_t >();
+
+			if ( Segment.empty() )
+			{
+				if ( Destination )
+				{
+					memset( Destination, 0, a_Size );
+				}
+
+				m_Capacity = m_Head - m_Data;
+				m_Overflow += a_Size;
+				return *this;
+			}
+
+			m_Base += m_Head - m_Data;
+			m_Data = m_Head = Segment.data();
+			m_Capacity = Segment.size();
+
+			if ( !a_Size )
+			{
+				return *this;
+			}
+		}
+	}
+
 	template < typename T, size_t... Idx >
 	void DeserialiseVariadic( T& a_Object, std::in_place_type_t< std::index_sequence< Idx... > > )
 	{
 		( ( *this >> std::get< Idx >( a_Object ) ), ... );
 	}
 
-	const byte_t* m_Data;
-	const byte_t* m_Head;
+	const byte_t*   m_Data;
+	const byte_t*   m_Head;
+	size_t          m_Capacity;
+	size_t          m_Base;
+	size_t          m_Overflow;
+	ISegmentReader* m_Segments;
+	size_t          m_Alignment;
+	size_t          m_StreamingThreshold;
+	bool            m_IsChecked;
+	bool            m_HasSkippedView;
 };
 
 // Given an object, a Sizer will calculate the serialised size of an object.
@@ -990,10 +1823,21 @@ private:
 // - If a type is an STL container, size the size type of the container, and then size each element individually.
 // - If a type has implemented OnSize(Sizer&) const, then this will be used to size the object.
 // - If none of the above, the object will be sized as a byte stream.
+// In upper bound mode the tally is instead a bound on the serialised size, for allocating a buffer without an exact walk. Containers
+// whose element type is bounded (byte stream sized types, std::arrays, pairs and tuples of them, or types with a static
+// size_t OnSizeBound()) are bounded from their size alone, types with void OnSizeBound( Sizer& ) const use it in place
+// of OnSize, and padding is counted at its worst. Hooks must include any padding of the alignment in use. The buffer can be
+// trimmed to the serialiser's GetBytesWritten() afterwards.
 class Sizer
 {
 public:
 
+	enum Mode
+	{
+		Exact,
+		UpperBound,
+	};
+
 	// Default element sizer functor for container sizing.
 	struct DefaultFunctor
 	{
@@ -1001,8 +1845,10 @@ public:
 		void operator()( Sizer& a_Sizer, const T& a_Object ) { a_Sizer + a_Object; }
 	};
 
-	Sizer()
+	Sizer( size_t a_Alignment = Serialisation::Packed, Mode a_Mode = Exact )
 		: m_Size( 0u )
+		, m_Alignment( a_Alignment )
+		, m_Mode( a_Mode )
 	{}
 
 	// Add explicit size value to the sizer's tally.
@@ -1012,6 +1858,18 @@ public:
 		return *this;
 	}
 
+	// Add the padding a serialiser with the same alignment places before a bulk payload of elements with the given alignment.
+	Sizer& AlignPayload( size_t a_Alignment )
+	{
+		if ( m_Alignment )
+		{
+			const size_t Alignment = a_Alignment < m_Alignment ? m_Alignment : a_Alignment;
+			m_Size += m_Mode == UpperBound ? Alignment - 1u : ( Alignment - m_Size % Alignment ) % Alignment;
+		}
+
+		return *this;
+	}
+
 	// Attempt to size the object if it has implemented the OnSize interface. Fallback to byte stream sizing.
 	template < typename T >
 	Sizer& AddSizeOfObject( const T& a_Object )
@@ -1052,6 +1910,7 @@ public:
 		AddSizeOfMemory( sizeof( a_Container.length() ) );
 
 		// Add the size of the entire string.
+		AlignPayload( alignof( typename std::basic_string< T... >::value_type ) );
 		AddSizeOfMemory( sizeof( *a_Container.data() ) * a_Container.length() );
 
 		return *this;
@@ -1061,14 +1920,16 @@ public:
 	template < typename T, size_t N, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( T( &a_Container )[ N ], Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< T, Functor >( N ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( N ) );
 
 		// Add the size of each element.
-		for ( const auto& Object : a_Container )
-		{
-			a_Functor( *this, Object );
-		}
+		Serialisation::SizeOfContiguous( *this, a_Container, N, a_Functor );
 
 		return *this;
 	}
@@ -1077,14 +1938,16 @@ public:
 	template < typename T, size_t N, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::array< T, N >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< T, Functor >( N ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( N ) );
 
 		// Add the size of each element.
-		for ( const auto& Object : a_Container )
-		{
-			a_Functor( *this, Object );
-		}
+		Serialisation::SizeOfContiguous( *this, a_Container.data(), N, a_Functor );
 
 		return *this;
 	}
@@ -1093,13 +1956,27 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::vector< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::vector< T... >::value_type, Functor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
 		// Add the size of each element.
-		for ( const auto& Object : a_Container )
+		if constexpr ( std::is_same_v< typename std::vector< T... >::value_type, bool > )
 		{
-			a_Functor( *this, Object );
+			AlignPayload( alignof( bool ) );
+
+			for ( const auto& Object : a_Container )
+			{
+				a_Functor( *this, Object );
+			}
+		}
+		else
+		{
+			Serialisation::SizeOfContiguous( *this, a_Container.data(), a_Container.size(), a_Functor );
 		}
 
 		return *this;
@@ -1109,6 +1986,11 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::list< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::list< T... >::value_type, Functor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1125,6 +2007,11 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::forward_list< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::forward_list< T... >::value_type, Functor >( std::distance( a_Container.begin(), a_Container.end() ) ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( std::distance( a_Container.begin(), a_Container.end() ) ) );
 
@@ -1141,6 +2028,11 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::deque< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::deque< T... >::value_type, Functor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1181,6 +2073,11 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::map< T... >& a_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::map< T... >::value_type, KeyFunctor, ValueFunctor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1198,6 +2095,11 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::multimap< T... >& a_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::multimap< T... >::value_type, KeyFunctor, ValueFunctor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1215,6 +2117,11 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::unordered_map< T... >& a_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::unordered_map< T... >::value_type, KeyFunctor, ValueFunctor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1232,6 +2139,11 @@ public:
 	template < typename... T, typename KeyFunctor = DefaultFunctor, typename ValueFunctor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::unordered_multimap< T... >& a_Container, KeyFunctor&& a_KeyFunctor = KeyFunctor{}, ValueFunctor&& a_ValueFunctor = ValueFunctor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::unordered_multimap< T... >::value_type, KeyFunctor, ValueFunctor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1249,6 +2161,11 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::set< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::set< T... >::value_type, Functor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1265,6 +2182,11 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::multiset< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::multiset< T... >::value_type, Functor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1281,6 +2203,11 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::unordered_set< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::unordered_set< T... >::value_type, Functor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1297,6 +2224,11 @@ public:
 	template < typename... T, typename Functor = DefaultFunctor >
 	Sizer& AddSizeOfContainer( const std::unordered_multiset< T... >& a_Container, Functor&& a_Functor = Functor{} )
 	{
+		if ( AddSizeBoundOfContainer< typename std::unordered_multiset< T... >::value_type, Functor >( a_Container.size() ) )
+		{
+			return *this;
+		}
+
 		// Add the size of size.
 		AddSizeOfMemory( sizeof( a_Container.size() ) );
 
@@ -1309,6 +2241,20 @@ public:
 		return *this;
 	}
 
+	// Size a container of polymorphic objects, or pointers to them, whose dynamic types are expected to be among Derived.
+	// Each element is sized through a non-virtual call. Elements of any other dynamic type fall back to virtual dispatch.
+	template < typename... Derived, typename T >
+	Sizer& AddSizeOfPolymorphicContainer( const T& a_Container )
+	{
+		// Add the size of size.
+		AddSizeOfMemory( sizeof( size_t ) );
+
+		// Add the size of each element.
+		Serialisation::SizeOfPolymorphic< Derived... >( *this, a_Container );
+
+		return *this;
+	}
+
 	// Automatically attempt to detect sizing strategy. First try to size as a container, then as an object, and if those fail, as a byte stream.
 	template < typename T >
 	inline Sizer& operator+( const T& a_ObjectOrContainer )
@@ -1319,8 +2265,33 @@ public:
 	// Implicit cast sizer's tally to a size_t.
 	operator size_t () const { return m_Size; }
 
+	// Whether the tally is an upper bound rather than the exact size.
+	inline bool IsUpperBound() const { return m_Mode == UpperBound; }
+
+	// Get the payload alignment the tally is made for.
+	inline size_t GetAlignment() const { return m_Alignment; }
+
 private:
 
+	// In upper bound mode, bound a container of elements of a bounded type from its size alone. Returns whether it did.
+	template < typename T, typename... Functor >
+	bool AddSizeBoundOfContainer( size_t a_Count )
+	{
+		if constexpr ( ( std::is_same_v< std::decay_t< Functor >, DefaultFunctor > && ... ) )
+		{
+			if ( m_Mode == UpperBound )
+			{
+				if ( const size_t Bound = Serialisation::GetSizeBoundOfContainer< std::remove_const_t< T > >( m_Alignment, a_Count ) )
+				{
+					m_Size += Bound;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
 	template < typename T, size_t... Idx >
 	void SizeOfVariadic( T& a_Object, std::in_place_type_t< std::index_sequence< Idx... > > )
 	{
@@ -1328,60 +2299,478 @@ private:
 	}
 
 	size_t m_Size;
+	size_t m_Alignment;
+	Mode   m_Mode;
 };
 
 template < typename T >
 void Serialisation::Serialise( Serialiser& a_Serialiser, const T& a_Object )
 {
-	if constexpr ( Serialisation::HasOnBeforeSerialise< T >::Value )
+	SERIALISATION_TRACE_SCOPE_IF( Serialisation::Dispatch< T >::HasOnSerialise, a_Serialiser, a_Object );
+
+	Serialisation::InvokeBeforeSerialise( a_Object );
+	Serialisation::InvokeSerialise( a_Serialiser, a_Object );
+	Serialisation::InvokeAfterSerialise( a_Object );
+}
+
+template < typename T >
+void Serialisation::Deserialise( Deserialiser& a_Deserialiser, T& o_Object )
+{
+	SERIALISATION_TRACE_SCOPE_IF( Serialisation::Dispatch< T >::HasOnDeserialise, a_Deserialiser, o_Object );
+
+	Serialisation::InvokeBeforeDeserialise( o_Object );
+	Serialisation::InvokeDeserialise( a_Deserialiser, o_Object );
+	Serialisation::InvokeAfterDeserialise( o_Object );
+}
+
+template < typename T >
+void Serialisation::SizeOf( Sizer& a_Sizer, const T& a_Object )
+{
+	Serialisation::InvokeSize( a_Sizer, a_Object );
+}
+
+template < typename T, typename Functor >
+void Serialisation::SerialiseContiguous( Serialiser& a_Serialiser, const T* a_Objects, size_t a_Count, Functor& a_Functor )
+{
+	constexpr bool IsDefault = std::is_same_v< std::decay_t< Functor >, Serialiser::DefaultFunctor >;
+	using Element = std::remove_const_t< T >;
+
+	if constexpr ( Serialisation::Dispatch< Element >::IsAlignedPayload )
+	{
+		a_Serialiser.AlignPayload( alignof( Element ) );
+	}
+
+	if constexpr ( IsDefault && Serialisation::Dispatch< Element >::HasOnBeforeSerialiseBatch )
 	{
-		const_cast< T& >( a_Object ).OnBeforeSerialise();
+		Element::OnBeforeSerialiseBatch( std::span< Element >( const_cast< Element* >( a_Objects ), a_Count ) );
 	}
 
-	if constexpr ( Serialisation::HasOnSerialise< T >::Value )
+	if constexpr ( IsDefault && Serialisation::Dispatch< Element >::IsSerialisedAsMemory )
 	{
-		a_Object.OnSerialise( a_Serialiser );
+		a_Serialiser.SerialiseAsMemory( a_Objects, sizeof( Element ) * a_Count );
+	}
+	else if constexpr ( IsDefault && Serialisation::Dispatch< Element >::HasOnBeforeSerialiseBatch && Serialisation::Dispatch< Element >::HasOnAfterSerialiseBatch )
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			Serialisation::InvokeSerialise( a_Serialiser, a_Objects[ i ] );
+		}
+	}
+	else if constexpr ( IsDefault && Serialisation::Dispatch< Element >::HasOnBeforeSerialiseBatch )
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			Serialisation::InvokeSerialise( a_Serialiser, a_Objects[ i ] );
+			Serialisation::InvokeAfterSerialise( a_Objects[ i ] );
+		}
+	}
+	else if constexpr ( IsDefault && Serialisation::Dispatch< Element >::HasOnAfterSerialiseBatch )
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			Serialisation::InvokeBeforeSerialise( a_Objects[ i ] );
+			Serialisation::InvokeSerialise( a_Serialiser, a_Objects[ i ] );
+		}
+	}
+	else
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			a_Functor( a_Serialiser, a_Objects[ i ] );
+		}
+	}
+
+	if constexpr ( IsDefault && Serialisation::Dispatch< Element >::HasOnAfterSerialiseBatch )
+	{
+		Element::OnAfterSerialiseBatch( std::span< Element >( const_cast< Element* >( a_Objects ), a_Count ) );
+	}
+}
+
+template < typename T, typename Functor >
+void Serialisation::DeserialiseContiguous( Deserialiser& a_Deserialiser, T* o_Objects, size_t a_Count, Functor& a_Functor )
+{
+	constexpr bool IsDefault = std::is_same_v< std::decay_t< Functor >, Deserialiser::DefaultFunctor >;
+
+	if constexpr ( Serialisation::Dispatch< T >::IsAlignedPayload )
+	{
+		a_Deserialiser.AlignPayload( alignof( T ) );
+	}
+
+	if constexpr ( IsDefault && Serialisation::Dispatch< T >::HasOnBeforeDeserialiseBatch )
+	{
+		T::OnBeforeDeserialiseBatch( std::span< T >( o_Objects, a_Count ) );
+	}
+
+	if constexpr ( IsDefault && Serialisation::Dispatch< T >::IsDeserialisedAsMemory )
+	{
+		a_Deserialiser.DeserialiseAsMemory( o_Objects, sizeof( T ) * a_Count );
+	}
+	else if constexpr ( IsDefault && Serialisation::Dispatch< T >::HasOnBeforeDeserialiseBatch && Serialisation::Dispatch< T >::HasOnAfterDeserialiseBatch )
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			Serialisation::InvokeDeserialise( a_Deserialiser, o_Objects[ i ] );
+		}
+	}
+	else if constexpr ( IsDefault && Serialisation::Dispatch< T >::HasOnBeforeDeserialiseBatch )
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			Serialisation::InvokeDeserialise( a_Deserialiser, o_Objects[ i ] );
+			Serialisation::InvokeAfterDeserialise( o_Objects[ i ] );
+		}
+	}
+	else if constexpr ( IsDefault && Serialisation::Dispatch< T >::HasOnAfterDeserialiseBatch )
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			Serialisation::InvokeBeforeDeserialise( o_Objects[ i ] );
+			Serialisation::InvokeDeserialise( a_Deserialiser, o_Objects[ i ] );
+		}
+	}
+	else
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			a_Functor( a_Deserialiser, o_Objects[ i ] );
+		}
+	}
+
+	if constexpr ( IsDefault && Serialisation::Dispatch< T >::HasOnAfterDeserialiseBatch )
+	{
+		T::OnAfterDeserialiseBatch( std::span< T >( o_Objects, a_Count ) );
+	}
+}
+
+template < typename T, typename Functor >
+void Serialisation::SizeOfContiguous( Sizer& a_Sizer, const T* a_Objects, size_t a_Count, Functor& a_Functor )
+{
+	if constexpr ( Serialisation::Dispatch< std::remove_const_t< T > >::IsAlignedPayload )
+	{
+		a_Sizer.AlignPayload( alignof( T ) );
+	}
+
+	if constexpr ( std::is_same_v< std::decay_t< Functor >, Sizer::DefaultFunctor > && Serialisation::Dispatch< std::remove_const_t< T > >::IsSizedAsMemory )
+	{
+		a_Sizer.AddSizeOfMemory( sizeof( T ) * a_Count );
+	}
+	else
+	{
+		for ( size_t i = 0; i < a_Count; ++i )
+		{
+			a_Functor( a_Sizer, a_Objects[ i ] );
+		}
+	}
+}
+
+template < typename... Derived, typename T >
+void Serialisation::SerialisePolymorphic( Serialiser& a_Serialiser, const T& a_Container )
+{
+	using Types = Serialisation::DynamicType< Derived... >;
+
+	// Run the before hooks one dynamic type at a time.
+	( [ & ]
+	{
+		for ( const auto& Element : a_Container )
+		{
+			const auto& Object = Serialisation::Dereference( Element );
+
+			if ( typeid( Object ) == typeid( Derived ) )
+			{
+				Serialisation::InvokeBeforeSerialise< Derived, true >( static_cast< const Derived& >( Object ) );
+			}
+		}
+	}(), ... );
+
+	for ( const auto& Element : a_Container )
+	{
+		const auto& Object = Serialisation::Dereference( Element );
+
+		if ( Types::IndexOf( Object ) == Types::Unknown )
+		{
+			Serialisation::InvokeBeforeSerialise( Object );
+		}
+	}
+
+	// Serialise every element in order.
+	for ( const auto& Element : a_Container )
+	{
+		const auto& Object = Serialisation::Dereference( Element );
+		Types::Visit( Object, Types::IndexOf( Object ), [ & ]( const auto& a_Object, auto a_IsExact )
+		{
+			Serialisation::InvokeSerialise< std::remove_cvref_t< decltype( a_Object ) >, decltype( a_IsExact )::value >( a_Serialiser, a_Object );
+		} );
+	}
+
+	// Run the after hooks one dynamic type at a time.
+	( [ & ]
+	{
+		for ( const auto& Element : a_Container )
+		{
+			const auto& Object = Serialisation::Dereference( Element );
+
+			if ( typeid( Object ) == typeid( Derived ) )
+			{
+				Serialisation::InvokeAfterSerialise< Derived, true >( static_cast< const Derived& >( Object ) );
+			}
+		}
+	}(), ... );
+
+	for ( const auto& Element : a_Container )
+	{
+		const auto& Object = Serialisation::Dereference( Element );
+
+		if ( Types::IndexOf( Object ) == Types::Unknown )
+		{
+			Serialisation::InvokeAfterSerialise( Object );
+		}
+	}
+}
+
+template < typename... Derived, typename T >
+void Serialisation::DeserialisePolymorphic( Deserialiser& a_Deserialiser, T& o_Container, size_t a_Size )
+{
+	using Types = Serialisation::DynamicType< Derived... >;
+
+	// Run the before hooks one dynamic type at a time.
+	( [ & ]
+	{
+		size_t Visited = 0;
+
+		for ( auto Element = o_Container.begin(); Visited < a_Size; ++Element, ++Visited )
+		{
+			auto& Object = Serialisation::Dereference( *Element );
+
+			if ( typeid( Object ) == typeid( Derived ) )
+			{
+				Serialisation::InvokeBeforeDeserialise< Derived, true >( static_cast< Derived& >( Object ) );
+			}
+		}
+	}(), ... );
+
+	size_t Count = 0;
+
+	for ( auto Element = o_Container.begin(); Count < a_Size; ++Element, ++Count )
+	{
+		auto& Object = Serialisation::Dereference( *Element );
+
+		if ( Types::IndexOf( Object ) == Types::Unknown )
+		{
+			Serialisation::InvokeBeforeDeserialise( Object );
+		}
+	}
+
+	// Deserialise every element in order.
+	Count = 0;
+
+	for ( auto Element = o_Container.begin(); Count < a_Size; ++Element, ++Count )
+	{
+		auto& Object = Serialisation::Dereference( *Element );
+		Types::Visit( Object, Types::IndexOf( Object ), [ & ]( auto& o_Object, auto a_IsExact )
+		{
+			Serialisation::InvokeDeserialise< std::remove_cvref_t< decltype( o_Object ) >, decltype( a_IsExact )::value >( a_Deserialiser, o_Object );
+		} );
+	}
+
+	// Run the after hooks one dynamic type at a time.
+	( [ & ]
+	{
+		size_t Visited = 0;
+
+		for ( auto Element = o_Container.begin(); Visited < a_Size; ++Element, ++Visited )
+		{
+			auto& Object = Serialisation::Dereference( *Element );
+
+			if ( typeid( Object ) == typeid( Derived ) )
+			{
+				Serialisation::InvokeAfterDeserialise< Derived, true >( static_cast< Derived& >( Object ) );
+			}
+		}
+	}(), ... );
+
+	Count = 0;
+
+	for ( auto Element = o_Container.begin(); Count < a_Size; ++Element, ++Count )
+	{
+		auto& Object = Serialisation::Dereference( *Element );
+
+		if ( Types::IndexOf( Object ) == Types::Unknown )
+		{
+			Serialisation::InvokeAfterDeserialise( Object );
+		}
+	}
+}
+
+template < typename... Derived, typename T >
+void Serialisation::SizeOfPolymorphic( Sizer& a_Sizer, const T& a_Container )
+{
+	using Types = Serialisation::DynamicType< Derived... >;
+
+	for ( const auto& Element : a_Container )
+	{
+		const auto& Object = Serialisation::Dereference( Element );
+		Types::Visit( Object, Types::IndexOf( Object ), [ & ]( const auto& a_Object, auto a_IsExact )
+		{
+			Serialisation::InvokeSize< std::remove_cvref_t< decltype( a_Object ) >, decltype( a_IsExact )::value >( a_Sizer, a_Object );
+		} );
+	}
+}
+
+template < typename T, bool IsExact >
+void Serialisation::InvokeBeforeSerialise( const T& a_Object )
+{
+	if constexpr ( Serialisation::Dispatch< T >::HasOnBeforeSerialise )
+	{
+		if constexpr ( IsExact )
+		{
+			const_cast< T& >( a_Object ).T::OnBeforeSerialise();
+		}
+		else
+		{
+			const_cast< T& >( a_Object ).OnBeforeSerialise();
+		}
+	}
+}
+
+template < typename T, bool IsExact >
+void Serialisation::InvokeSerialise( Serialiser& a_Serialiser, const T& a_Object )
+{
+	if constexpr ( Serialisation::Dispatch< T >::HasOnSerialise )
+	{
+		if constexpr ( IsExact )
+		{
+			a_Object.T::OnSerialise( a_Serialiser );
+		}
+		else
+		{
+			a_Object.OnSerialise( a_Serialiser );
+		}
 	}
 	else
 	{
 		a_Serialiser.SerialiseAsMemory( &a_Object, sizeof( a_Object ) );
 	}
+}
 
-	if constexpr ( Serialisation::HasOnAfterSerialise< T >::Value )
+template < typename T, bool IsExact >
+void Serialisation::InvokeAfterSerialise( const T& a_Object )
+{
+	if constexpr ( Serialisation::Dispatch< T >::HasOnAfterSerialise )
 	{
-		const_cast< T& >( a_Object ).OnAfterSerialise();
+		if constexpr ( IsExact )
+		{
+			const_cast< T& >( a_Object ).T::OnAfterSerialise();
+		}
+		else
+		{
+			const_cast< T& >( a_Object ).OnAfterSerialise();
+		}
 	}
 }
 
-template < typename T >
-void Serialisation::Deserialise( Deserialiser& a_Deserialiser, T& o_Object )
+template < typename T, typename Archive, bool IsExact >
+void Serialisation::InvokeSerialiseFor( Archive& a_Archive, const T& a_Object )
+{
+	if constexpr ( IsExact )
+	{
+		a_Object.T::OnSerialise( a_Archive );
+	}
+	else
+	{
+		a_Object.OnSerialise( a_Archive );
+	}
+}
+
+template < typename T, bool IsExact >
+void Serialisation::InvokeBeforeDeserialise( T& o_Object )
 {
-	if constexpr ( Serialisation::HasOnBeforeDeserialise< T >::Value )
+	if constexpr ( Serialisation::Dispatch< T >::HasOnBeforeDeserialise )
 	{
-		const_cast< T& >( o_Object ).OnBeforeDeserialise();
+		if constexpr ( IsExact )
+		{
+			o_Object.T::OnBeforeDeserialise();
+		}
+		else
+		{
+			o_Object.OnBeforeDeserialise();
+		}
 	}
+}
 
-	if constexpr ( Serialisation::HasOnDeserialise< T >::Value )
+template < typename T, bool IsExact >
+void Serialisation::InvokeDeserialise( Deserialiser& a_Deserialiser, T& o_Object )
+{
+	if constexpr ( Serialisation::Dispatch< T >::HasOnDeserialise )
 	{
-		o_Object.OnDeserialise( a_Deserialiser );
+		if constexpr ( IsExact )
+		{
+			o_Object.T::OnDeserialise( a_Deserialiser );
+		}
+		else
+		{
+			o_Object.OnDeserialise( a_Deserialiser );
+		}
 	}
 	else
 	{
 		a_Deserialiser.DeserialiseAsMemory( &o_Object, sizeof( o_Object ) );
 	}
+}
 
-	if constexpr ( Serialisation::HasOnAfterDeserialise< T >::Value )
+template < typename T, bool IsExact >
+void Serialisation::InvokeAfterDeserialise( T& o_Object )
+{
+	if constexpr ( Serialisation::Dispatch< T >::HasOnAfterDeserialise )
 	{
-		const_cast< T& >( o_Object ).OnAfterDeserialise();
+		if constexpr ( IsExact )
+		{
+			o_Object.T::OnAfterDeserialise();
+		}
+		else
+		{
+			o_Object.OnAfterDeserialise();
+		}
 	}
 }
 
-template < typename T >
-void Serialisation::SizeOf( Sizer& a_Sizer, const T& a_Object )
+template < typename T, bool IsExact >
+void Serialisation::InvokeSize( Sizer& a_Sizer, const T& a_Object )
 {
-	if constexpr ( Serialisation::HasOnSize< T >::Value )
+	if constexpr ( Serialisation::Dispatch< T >::HasStaticOnSizeBound )
 	{
-		a_Object.OnSize( a_Sizer );
+		if ( a_Sizer.IsUpperBound() )
+		{
+			a_Sizer.AddSizeOfMemory( T::OnSizeBound() );
+			return;
+		}
+	}
+	else if constexpr ( Serialisation::Dispatch< T >::HasOnSizeBound )
+	{
+		if ( a_Sizer.IsUpperBound() )
+		{
+			if constexpr ( IsExact )
+			{
+				a_Object.T::OnSizeBound( a_Sizer );
+			}
+			else
+			{
+				a_Object.OnSizeBound( a_Sizer );
+			}
+
+			return;
+		}
+	}
+
+	if constexpr ( Serialisation::Dispatch< T >::HasOnSize )
+	{
+		if constexpr ( IsExact )
+		{
+			a_Object.T::OnSize( a_Sizer );
+		}
+		else
+		{
+			a_Object.OnSize( a_Sizer );
+		}
 	}
 	else
 	{
@@ -0,0 +1,579 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#elif defined( __linux__ )
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#endif
+
+//==========================================================================
+// Zero copy transfer of serialised objects between processes on one host,
+// through a ring of fixed size slots in shared memory. The producer
+// serialises straight into the slots, and the consumer deserialises from
+// them in place, so the only copies made are the ones the archives make:
+// SharedRing Ring( "/World", 16, 1024 * 1024 );      // Producer.
+// SharedRing::Writer Writer( Ring );
+// Serialiser serialiser( Writer );
+// serialiser << World;
+// serialiser.Flush();
+//
+// SharedRing Ring( "/World" );                       // Consumer.
+// SharedRing::Reader Reader( Ring );
+// Deserialiser deserialiser( Reader );
+// deserialiser >> World;
+//
+// A message takes as many slots as it needs, up to the whole ring, and each
+// slot is published as soon as it is full, so the consumer starts reading
+// before the producer has finished. The Reader holds the slots of its message
+// until it is destroyed, so views read with DeserialiseAsView stay valid
+// until then. Slots are cache line aligned and a multiple of a cache line in
+// size, so aligned streams give aligned views.
+//
+// The indices are lock free, and a side only waits in the kernel, on a
+// futex, when the ring is full or empty; the other side only makes a system
+// call to wake it when it is known to be asleep. Rings are named (shm_open,
+// or a named file mapping on Windows) or anonymous (memfd_create), shared by
+// passing the handle to a child or over a Unix socket. Windows has no
+// futex across processes, so a waiting side there polls, yielding.
+//==========================================================================
+class SharedRing
+{
+public:
+
+#if defined( _WIN32 )
+	using Handle = HANDLE;
+	static inline const Handle InvalidHandle = nullptr;
+#else
+	using Handle = int;
+	static constexpr Handle InvalidHandle = -1;
+#endif
+
+	// Slot sizes are rounded up to a multiple of this, and slots start on it.
+	static constexpr size_t SlotAlignment = 64u;
+
+	// Create an anonymous ring, shared by handing GetHandle() on to the other process. The slot count is rounded up to a power of two.
+	SharedRing( size_t a_SlotCount, size_t a_SlotSize )
+		: SharedRing()
+	{
+		Create( nullptr, a_SlotCount, a_SlotSize );
+	}
+
+	// Create a named ring, replacing any ring of the same name. The name is removed when the creator is destroyed.
+	SharedRing( const std::string& a_Name, size_t a_SlotCount, size_t a_SlotSize )
+		: SharedRing()
+	{
+		Create( a_Name.c_str(), a_SlotCount, a_SlotSize );
+	}
+
+	// Open a named ring created by another process.
+	explicit SharedRing( const std::string& a_Name )
+		: SharedRing()
+	{
+#if defined( _WIN32 )
+		Map( OpenFileMappingA( FILE_MAP_ALL_ACCESS, FALSE, a_Name.c_str() ) );
+#elif defined( __linux__ )
+		Map( shm_open( a_Name.c_str(), O_RDWR, 0 ) );
+#endif
+	}
+
+	// Open a ring from a handle passed on by the process that created it. The ring takes ownership of the handle.
+	explicit SharedRing( Handle a_Handle )
+		: SharedRing()
+	{
+		Map( a_Handle );
+	}
+
+	~SharedRing()
+	{
+#if defined( _WIN32 )
+		if ( m_Header )
+		{
+			UnmapViewOfFile( m_Header );
+		}
+
+		if ( m_Handle != InvalidHandle )
+		{
+			CloseHandle( m_Handle );
+		}
+#elif defined( __linux__ )
+		if ( m_Header )
+		{
+			munmap( m_Header, m_MappingSize );
+		}
+
+		if ( m_Handle != InvalidHandle )
+		{
+			close( m_Handle );
+		}
+
+		if ( !m_Name.empty() )
+		{
+			shm_unlink( m_Name.c_str() );
+		}
+#endif
+	}
+
+	SharedRing( const SharedRing& ) = delete;
+	SharedRing& operator=( const SharedRing& ) = delete;
+
+	// Get whether the ring was created or opened.
+	inline bool IsOpen() const { return m_Header; }
+
+	// Get the handle of the shared memory, to pass on to another process.
+	inline Handle GetHandle() const { return m_Handle; }
+
+	inline size_t GetSlotCount() const { return m_Header->SlotCount; }
+
+	inline size_t GetSlotSize() const { return m_Header->SlotSize; }
+
+	// Tell the consumer that no more messages will be written. A Reader finding the ring empty after this ends at once.
+	void Close()
+	{
+		m_Header->IsClosed.store( 1u, std::memory_order_seq_cst );
+		Signal( m_Header->Published, m_Header->ConsumerSleepers );
+	}
+
+	inline bool IsClosed() const { return m_Header->IsClosed.load( std::memory_order_acquire ); }
+
+	// Writes one message into the ring, through a Serialiser. Only one Writer may be writing to a ring at a time.
+	class Writer : public ISegmentWriter
+	{
+	public:
+
+		Writer( SharedRing& a_Ring )
+			: m_Ring( a_Ring )
+			, m_Position( a_Ring.m_Header->Head.load( std::memory_order_relaxed ) )
+			, m_Count( 0u )
+			, m_IsOpen( false )
+			, m_IsTruncated( false )
+		{}
+
+		// Get whether the message was larger than the whole ring and was cut short. Complete once the Serialiser is flushed.
+		inline bool IsTruncated() const { return m_IsTruncated; }
+
+	private:
+
+		std::span< byte_t > GetNextSegment( size_t a_Used ) override
+		{
+			// Keep the last slot of the ring unpublished, for Commit to end the message in; the Reader cannot release slots
+			// until it sees the end, so waiting for one here would never return.
+			if ( m_IsOpen && m_Count == m_Ring.m_Header->SlotCount )
+			{
+				m_IsTruncated = true;
+				return {};
+			}
+
+			if ( m_IsOpen )
+			{
+				Publish( a_Used, 0u );
+			}
+
+			return Acquire();
+		}
+
+		void Commit( size_t a_Used ) override
+		{
+			if ( !m_IsOpen )
+			{
+				Acquire();
+			}
+
+			Publish( a_Used, Last | ( m_IsTruncated ? Truncated : 0u ) );
+		}
+
+		std::span< byte_t > Acquire()
+		{
+			Header& Shared = *m_Ring.m_Header;
+
+			// Wait for the consumer to release the slot.
+			for ( ;; )
+			{
+				const uint32_t Tail = Shared.Tail.load( std::memory_order_acquire );
+
+				if ( m_Position - Tail < Shared.SlotCount )
+				{
+					break;
+				}
+
+				SharedRing::Wait( Shared.Tail, Tail, Shared.ProducerSleepers, [ & ]() { return false; } );
+			}
+
+			m_IsOpen = true;
+			++m_Count;
+			return { m_Ring.GetSlotData( m_Position ), Shared.SlotSize };
+		}
+
+		void Publish( size_t a_Size, uint32_t a_Flags )
+		{
+			Header& Shared = *m_Ring.m_Header;
+			Slot& Published = m_Ring.GetSlot( m_Position );
+			Published.Size = static_cast< uint32_t >( a_Size );
+			Published.Flags = a_Flags;
+
+			Shared.Head.store( ++m_Position, std::memory_order_seq_cst );
+			Signal( Shared.Published, Shared.ConsumerSleepers );
+			m_IsOpen = false;
+		}
+
+		SharedRing& m_Ring;
+		uint32_t    m_Position;
+		size_t      m_Count;
+		bool        m_IsOpen;
+		bool        m_IsTruncated;
+	};
+
+	// Reads one message from the ring in place, through a Deserialiser, waiting for it as needed. The slots of the message
+	// are released when the Reader is destroyed, skipping what was left unread.
+	class Reader : public ISegmentReader
+	{
+	public:
+
+		Reader( SharedRing& a_Ring )
+			: m_Ring( a_Ring )
+			, m_Begin( a_Ring.m_Header->Tail.load( std::memory_order_relaxed ) )
+			, m_Position( m_Begin )
+			, m_IsEnded( false )
+			, m_IsTruncated( false )
+			, m_IsClosed( false )
+		{}
+
+		~Reader()
+		{
+			if ( m_Position == m_Begin )
+			{
+				return;
+			}
+
+			while ( !m_IsEnded )
+			{
+				GetNextSegment();
+			}
+
+			Header& Shared = *m_Ring.m_Header;
+			Shared.Tail.store( m_Position, std::memory_order_seq_cst );
+
+			if ( Shared.ProducerSleepers.load( std::memory_order_seq_cst ) )
+			{
+				SharedRing::Wake( Shared.Tail );
+			}
+		}
+
+		Reader( const Reader& ) = delete;
+		Reader& operator=( const Reader& ) = delete;
+
+		std::span< const byte_t > GetNextSegment() override
+		{
+			if ( m_IsEnded )
+			{
+				return {};
+			}
+
+			Header& Shared = *m_Ring.m_Header;
+
+			for ( ;; )
+			{
+				const uint32_t Published = Shared.Published.load( std::memory_order_seq_cst );
+
+				if ( Shared.Head.load( std::memory_order_acquire ) != m_Position )
+				{
+					break;
+				}
+
+				if ( Shared.IsClosed.load( std::memory_order_acquire ) )
+				{
+					m_IsEnded = true;
+					m_IsClosed = m_Position == m_Begin;
+					m_IsTruncated = !m_IsClosed;
+					return {};
+				}
+
+				SharedRing::Wait( Shared.Published, Published, Shared.ConsumerSleepers, [ & ]() { return Shared.Head.load( std::memory_order_seq_cst ) != m_Position; } );
+			}
+
+			const Slot& Next = m_Ring.GetSlot( m_Position );
+			const size_t Size = Next.Size < Shared.SlotSize ? Next.Size : Shared.SlotSize;
+			m_IsEnded = Next.Flags & Last;
+			m_IsTruncated = Next.Flags & Truncated;
+
+			return { m_Ring.GetSlotData( m_Position++ ), Size };
+		}
+
+		// Get whether the ring was closed instead of holding another message.
+		inline bool IsClosed() const { return m_IsClosed; }
+
+		// Get whether the message was cut short, by a producer that ran out of ring or closed it mid-message.
+		inline bool IsTruncated() const { return m_IsTruncated; }
+
+	private:
+
+		SharedRing& m_Ring;
+		uint32_t    m_Begin;
+		uint32_t    m_Position;
+		bool        m_IsEnded;
+		bool        m_IsTruncated;
+		bool        m_IsClosed;
+	};
+
+private:
+
+	static constexpr uint32_t Magic = 0x474E5253u;
+
+	enum SlotFlags : uint32_t
+	{
+		Last = 1u << 0u,
+		Truncated = 1u << 1u,
+	};
+
+	static_assert( std::atomic< uint32_t >::is_always_lock_free, "Shared indices must be lock free to be shared between processes." );
+
+	// Positions count slots from the start and wrap, so the slot count is a power of two.
+	struct Header
+	{
+		std::atomic< uint32_t > Magic;
+		uint32_t                SlotCount;
+		uint64_t                SlotSize;
+		std::atomic< uint32_t > IsClosed;
+
+		// Written by the producer: slots published, and a count of events the consumer waits on.
+		alignas( SlotAlignment ) std::atomic< uint32_t > Head;
+		std::atomic< uint32_t > Published;
+		std::atomic< uint32_t > ProducerSleepers;
+
+		// Written by the consumer: slots released.
+		alignas( SlotAlignment ) std::atomic< uint32_t > Tail;
+		std::atomic< uint32_t > ConsumerSleepers;
+	};
+
+	struct Slot
+	{
+		uint32_t Size;
+		uint32_t Flags;
+	};
+
+	SharedRing()
+		: m_Header( nullptr )
+		, m_Slots( nullptr )
+		, m_Data( nullptr )
+		, m_MappingSize( 0u )
+		, m_Handle( InvalidHandle )
+	{}
+
+	// The header, then the slot headers, then the slot data, each cache line aligned.
+	static size_t GetSlotsOffset() { return ( sizeof( Header ) + SlotAlignment - 1u ) / SlotAlignment * SlotAlignment; }
+
+	static size_t GetDataOffset( size_t a_SlotCount )
+	{
+		return ( GetSlotsOffset() + sizeof( Slot ) * a_SlotCount + SlotAlignment - 1u ) / SlotAlignment * SlotAlignment;
+	}
+
+	inline Slot& GetSlot( uint32_t a_Position ) const { return m_Slots[ a_Position & ( m_Header->SlotCount - 1u ) ]; }
+
+	inline byte_t* GetSlotData( uint32_t a_Position ) const { return m_Data + ( a_Position & ( m_Header->SlotCount - 1u ) ) * m_Header->SlotSize; }
+
+	void Create( const char* a_Name, size_t a_SlotCount, size_t a_SlotSize )
+	{
+		size_t SlotCount = 1u;
+
+		while ( SlotCount < a_SlotCount && SlotCount < ( size_t( 1u ) << 30u ) )
+		{
+			SlotCount <<= 1u;
+		}
+
+		// Slot sizes are published as 32 bits.
+		const size_t SlotSize = ( ( a_SlotSize ? a_SlotSize : 1u ) + SlotAlignment - 1u ) / SlotAlignment * SlotAlignment;
+
+		if ( SlotSize > UINT32_MAX )
+		{
+			return;
+		}
+
+		const size_t Size = GetDataOffset( SlotCount ) + SlotCount * SlotSize;
+
+#if defined( _WIN32 )
+		SECURITY_ATTRIBUTES Attributes = { sizeof( SECURITY_ATTRIBUTES ), nullptr, a_Name ? FALSE : TRUE };
+		m_Handle = CreateFileMappingA( INVALID_HANDLE_VALUE, &Attributes, PAGE_READWRITE, static_cast< DWORD >( static_cast< uint64_t >( Size ) >> 32u ), static_cast< DWORD >( Size ), a_Name );
+
+		if ( !m_Handle )
+		{
+			return;
+		}
+
+		void* Mapping = MapViewOfFile( m_Handle, FILE_MAP_ALL_ACCESS, 0, 0, Size );
+#elif defined( __linux__ )
+		if ( a_Name )
+		{
+			shm_unlink( a_Name );
+			m_Handle = shm_open( a_Name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+			m_Name = m_Handle != InvalidHandle ? a_Name : "";
+		}
+#if defined( SYS_memfd_create )
+		else
+		{
+			m_Handle = static_cast< int >( syscall( SYS_memfd_create, "SharedRing", 0u ) );
+		}
+#endif
+
+		if ( m_Handle == InvalidHandle || ftruncate( m_Handle, static_cast< off_t >( Size ) ) )
+		{
+			return;
+		}
+
+		void* Mapping = mmap( nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, m_Handle, 0 );
+		Mapping = Mapping == MAP_FAILED ? nullptr : Mapping;
+#else
+		( void )a_Name;
+		void* Mapping = nullptr;
+#endif
+
+		if ( !Mapping )
+		{
+			return;
+		}
+
+		// The memory starts zeroed. Publish the header last, for a process opening the ring while it is being created.
+		m_Header = new ( Mapping ) Header{};
+		m_Header->SlotCount = static_cast< uint32_t >( SlotCount );
+		m_Header->SlotSize = SlotSize;
+		m_Header->Magic.store( Magic, std::memory_order_release );
+
+		m_Slots = reinterpret_cast< Slot* >( static_cast< byte_t* >( Mapping ) + GetSlotsOffset() );
+		m_Data = static_cast< byte_t* >( Mapping ) + GetDataOffset( SlotCount );
+		m_MappingSize = Size;
+	}
+
+	void Map( Handle a_Handle )
+	{
+		m_Handle = a_Handle;
+
+		if ( m_Handle == InvalidHandle )
+		{
+			return;
+		}
+
+#if defined( _WIN32 )
+		void* Mapping = MapViewOfFile( m_Handle, FILE_MAP_ALL_ACCESS, 0, 0, 0 );
+		MEMORY_BASIC_INFORMATION Information = {};
+		const size_t Size = Mapping && VirtualQuery( Mapping, &Information, sizeof( Information ) ) ? Information.RegionSize : 0u;
+#elif defined( __linux__ )
+		struct stat Status;
+		const size_t Size = fstat( m_Handle, &Status ) ? 0u : static_cast< size_t >( Status.st_size );
+		void* Mapping = Size >= sizeof( Header ) ? mmap( nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, m_Handle, 0 ) : MAP_FAILED;
+		Mapping = Mapping == MAP_FAILED ? nullptr : Mapping;
+#else
+		const size_t Size = 0u;
+		void* Mapping = nullptr;
+#endif
+
+		if ( !Mapping )
+		{
+			return;
+		}
+
+		m_Header = static_cast< Header* >( Mapping );
+		m_MappingSize = Size;
+
+		// Reject memory that is not a ring, or is smaller than its header says.
+		const size_t SlotCount = m_Header->SlotCount;
+		const bool IsValid = Size >= sizeof( Header ) && m_Header->Magic.load( std::memory_order_acquire ) == Magic && SlotCount && !( SlotCount & ( SlotCount - 1u ) ) &&
+			m_Header->SlotSize && m_Header->SlotSize <= UINT32_MAX && GetDataOffset( SlotCount ) + SlotCount * m_Header->SlotSize <= Size;
+
+		if ( !IsValid )
+		{
+#if defined( _WIN32 )
+			UnmapViewOfFile( Mapping );
+#elif defined( __linux__ )
+			munmap( Mapping, Size );
+#endif
+			m_Header = nullptr;
+			m_MappingSize = 0u;
+			return;
+		}
+
+		m_Slots = reinterpret_cast< Slot* >( static_cast< byte_t* >( Mapping ) + GetSlotsOffset() );
+		m_Data = static_cast< byte_t* >( Mapping ) + GetDataOffset( SlotCount );
+	}
+
+	// Wait for a shared value to change from a_Value, or for a_IsReady to hold. Spins briefly first, then sleeps, counted in
+	// a_Sleepers so that the other side knows to wake it.
+	template < typename Predicate >
+	static void Wait( std::atomic< uint32_t >& a_Word, uint32_t a_Value, std::atomic< uint32_t >& a_Sleepers, Predicate&& a_IsReady )
+	{
+		for ( size_t i = 0; i < 256u; ++i )
+		{
+			if ( a_Word.load( std::memory_order_acquire ) != a_Value || a_IsReady() )
+			{
+				return;
+			}
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+			_mm_pause();
+#endif
+		}
+
+		a_Sleepers.fetch_add( 1u, std::memory_order_seq_cst );
+
+		while ( a_Word.load( std::memory_order_seq_cst ) == a_Value && !a_IsReady() )
+		{
+#if defined( __linux__ )
+			// Not FUTEX_PRIVATE_FLAG, since the word is shared between processes.
+			syscall( SYS_futex, reinterpret_cast< uint32_t* >( &a_Word ), FUTEX_WAIT, a_Value, nullptr, nullptr, 0 );
+#else
+			std::this_thread::yield();
+#endif
+		}
+
+		a_Sleepers.fetch_sub( 1u, std::memory_order_seq_cst );
+	}
+
+	static void Wake( std::atomic< uint32_t >& a_Word )
+	{
+#if defined( __linux__ )
+		syscall( SYS_futex, reinterpret_cast< uint32_t* >( &a_Word ), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0 );
+#else
+		( void )a_Word;
+#endif
+	}
+
+	// Bump an event count and wake any side sleeping on it.
+	static void Signal( std::atomic< uint32_t >& a_Word, std::atomic< uint32_t >& a_Sleepers )
+	{
+		a_Word.fetch_add( 1u, std::memory_order_seq_cst );
+
+		if ( a_Sleepers.load( std::memory_order_seq_cst ) )
+		{
+			Wake( a_Word );
+		}
+	}
+
+	Header*     m_Header;
+	Slot*       m_Slots;
+	byte_t*     m_Data;
+	size_t      m_MappingSize;
+	Handle      m_Handle;
+	std::string m_Name;
+};
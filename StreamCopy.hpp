@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// The streaming stores need SSE2, which 32 bit x86 targets only have when built for it.
+#if defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+#include <immintrin.h>
+#define STREAM_COPY_SSE2 1
+#else
+#define STREAM_COPY_SSE2 0
+#endif
+
+//==========================================================================
+// Copy kernels for payloads too large to be worth caching. Streaming copies
+// write the destination with non-temporal stores, so a buffer bound for a
+// socket or disk does not evict the working set of other threads. Prefetched
+// copies pull the source in ahead of a regular copy, for reading out of a
+// large buffer that is not going to be read again.
+//==========================================================================
+namespace StreamCopy
+{
+// Default size from which archives switch to the streaming kernels. Roughly
+// the point at which a copy no longer fits alongside the working set in the LLC.
+static constexpr size_t DefaultThreshold = 4u * 1024u * 1024u;
+
+// Granularity of prefetched copies, and how far ahead of the copy the source is prefetched.
+static constexpr size_t PageSize = 4096u;
+static constexpr size_t PrefetchDistance = 2u * PageSize;
+
+// Copy with non-temporal stores. Falls back to memcpy where streaming stores are not available.
+inline void Copy( void* o_Destination, const void* a_Source, size_t a_Size )
+{
+#if STREAM_COPY_SSE2
+	auto* Destination = static_cast< uint8_t* >( o_Destination );
+	auto* Source = static_cast< const uint8_t* >( a_Source );
+
+	// Copy up to the first vector aligned destination address.
+	const size_t Head = ( 0u - reinterpret_cast< uintptr_t >( Destination ) ) & 31u;
+
+	if ( a_Size < Head + 128u )
+	{
+		memcpy( Destination, Source, a_Size );
+		return;
+	}
+
+	memcpy( Destination, Source, Head );
+	Destination += Head;
+	Source += Head;
+	a_Size -= Head;
+
+#if defined( __AVX__ )
+	for ( ; a_Size >= 128u; a_Size -= 128u, Destination += 128u, Source += 128u )
+	{
+		const __m256i A = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( Source ) );
+		const __m256i B = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( Source + 32u ) );
+		const __m256i C = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( Source + 64u ) );
+		const __m256i D = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( Source + 96u ) );
+		_mm256_stream_si256( reinterpret_cast< __m256i* >( Destination ), A );
+		_mm256_stream_si256( reinterpret_cast< __m256i* >( Destination + 32u ), B );
+		_mm256_stream_si256( reinterpret_cast< __m256i* >( Destination + 64u ), C );
+		_mm256_stream_si256( reinterpret_cast< __m256i* >( Destination + 96u ), D );
+	}
+#else
+	for ( ; a_Size >= 64u; a_Size -= 64u, Destination += 64u, Source += 64u )
+	{
+		const __m128i A = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Source ) );
+		const __m128i B = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Source + 16u ) );
+		const __m128i C = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Source + 32u ) );
+		const __m128i D = _mm_loadu_si128( reinterpret_cast< const __m128i* >( Source + 48u ) );
+		_mm_stream_si128( reinterpret_cast< __m128i* >( Destination ), A );
+		_mm_stream_si128( reinterpret_cast< __m128i* >( Destination + 16u ), B );
+		_mm_stream_si128( reinterpret_cast< __m128i* >( Destination + 32u ), C );
+		_mm_stream_si128( reinterpret_cast< __m128i* >( Destination + 48u ), D );
+	}
+#endif
+
+	// Order the streaming stores before anything that follows, then copy the tail.
+	_mm_sfence();
+	memcpy( Destination, Source, a_Size );
+#else
+	memcpy( o_Destination, a_Source, a_Size );
+#endif
+}
+
+// Copy a page at a time while prefetching the start of the pages ahead of the copy. Hardware prefetchers
+// stop at page boundaries, so this keeps a long sequential read streaming across them.
+inline void PrefetchCopy( void* o_Destination, const void* a_Source, size_t a_Size )
+{
+	auto* Destination = static_cast< uint8_t* >( o_Destination );
+	auto* Source = static_cast< const uint8_t* >( a_Source );
+
+	for ( ; a_Size >= PrefetchDistance + PageSize; a_Size -= PageSize, Destination += PageSize, Source += PageSize )
+	{
+#if STREAM_COPY_SSE2
+		_mm_prefetch( reinterpret_cast< const char* >( Source + PrefetchDistance ), _MM_HINT_T0 );
+		_mm_prefetch( reinterpret_cast< const char* >( Source + PrefetchDistance + 64u ), _MM_HINT_T0 );
+#elif defined( __GNUC__ )
+		__builtin_prefetch( Source + PrefetchDistance, 0, 3 );
+		__builtin_prefetch( Source + PrefetchDistance + 64u, 0, 3 );
+#endif
+		memcpy( Destination, Source, PageSize );
+	}
+
+	memcpy( Destination, Source, a_Size );
+}
+} // StreamCopy
@@ -0,0 +1,559 @@
+#pragma once
+#include <Utils/Serialisation.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+//==========================================================================
+// Task parallel serialisation of object trees. Subtrees wrapped in
+// AsParallel are serialised on a work stealing TaskPool, each into a stream
+// of its own, while the Serialiser carries on past them. The streams are
+// spliced back together at the offsets the subtrees were met at, so the
+// result is exactly the stream a single thread writes, and is read back by a
+// plain Deserialiser:
+// void OnSerialise( Serialiser& a_Serialiser ) const
+// {
+//     a_Serialiser << Name << AsParallel( Terrain ) << AsParallel( Entities );
+// }
+//
+// TaskPool Pool;
+// TaskWriter Writer( Pool );
+// Serialiser serialiser( Writer );
+// serialiser << World;
+// serialiser.Flush(); // Waits for every task.
+//
+// TaskWriter::Reader Reader( Writer );
+// Deserialiser deserialiser( Reader );
+// deserialiser >> World;
+//
+// A subtree is only split off if the upper bound Sizer puts it at or over the
+// writer's threshold, so wrapping small or empty nodes costs a sizing pass
+// and nothing more. Subtrees nest: one met inside a task is spawned from that
+// task. The spliced stream can also be gathered for a vectored write, or
+// copied out. Only packed streams are split; with an alignment, padding
+// depends on the absolute offset, so subtrees are serialised in place.
+//
+// A task reads its subtree after the hook that wrapped it has returned, up
+// until the Flush, so only wrap objects that outlive the Flush, such as
+// members, never locals or temporaries of the hook. An exception thrown by a
+// task is rethrown from the Flush once every task has finished.
+//==========================================================================
+
+// A pool of threads running tasks from per-thread deques. A thread runs its own newest task first, keeping to the subtree
+// it just opened, and an idle thread steals the oldest task of another, which tends to be the largest piece of work left.
+class TaskPool
+{
+public:
+
+	using Task = std::function< void() >;
+
+	// Counts the tasks spawned into it that have not finished, so that they can be waited for together.
+	class Group
+	{
+	public:
+
+		Group() = default;
+		Group( const Group& ) = delete;
+		Group& operator=( const Group& ) = delete;
+
+		inline bool IsDone() const { return !m_Pending.load( std::memory_order_acquire ); }
+
+		// Rethrow the first exception thrown by a task of the group, if any, clearing it. Call once the group is done.
+		void Rethrow()
+		{
+			if ( m_HasFailed.exchange( false, std::memory_order_acquire ) )
+			{
+				std::exception_ptr Error = std::move( m_Error );
+				m_Error = nullptr;
+				m_IsFailing.store( false, std::memory_order_relaxed );
+				std::rethrow_exception( Error );
+			}
+		}
+
+	private:
+
+		friend class TaskPool;
+
+		std::atomic< size_t > m_Pending = 0;
+		std::atomic< bool >   m_IsFailing = false;
+		std::atomic< bool >   m_HasFailed = false;
+		std::exception_ptr    m_Error;
+	};
+
+	// Leave a core for the thread that spawns the first tasks, which helps run them while it waits.
+	static size_t GetDefaultThreads()
+	{
+		const size_t Cores = std::thread::hardware_concurrency();
+		return Cores > 1u ? Cores - 1u : 1u;
+	}
+
+	// With no threads, tasks are run by the threads waiting for them.
+	TaskPool( size_t a_Threads = GetDefaultThreads() )
+		: m_Queues( a_Threads + 1u )
+		, m_Signal( 0u )
+		, m_Completed( 0u )
+		, m_Stop( false )
+	{
+		for ( size_t i = 0; i < a_Threads; ++i )
+		{
+			m_Threads.emplace_back( [ this, i ]() { Work( i ); } );
+		}
+	}
+
+	~TaskPool()
+	{
+		m_Stop.store( true, std::memory_order_release );
+		m_Signal.fetch_add( 1u, std::memory_order_release );
+		m_Signal.notify_all();
+
+		for ( std::thread& Thread : m_Threads )
+		{
+			Thread.join();
+		}
+	}
+
+	TaskPool( const TaskPool& ) = delete;
+	TaskPool& operator=( const TaskPool& ) = delete;
+
+	inline size_t GetThreadCount() const { return m_Threads.size(); }
+
+	// Queue a task on the calling thread's deque. Threads outside the pool share one deque, which the pool steals from.
+	void Spawn( Group& a_Group, Task a_Task )
+	{
+		a_Group.m_Pending.fetch_add( 1u, std::memory_order_relaxed );
+
+		Queue& Target = m_Queues[ GetIndex() ];
+		{
+			std::lock_guard Lock( Target.Mutex );
+			Target.Tasks.push_back( { std::move( a_Task ), &a_Group } );
+		}
+
+		m_Signal.fetch_add( 1u, std::memory_order_release );
+		m_Signal.notify_one();
+	}
+
+	// Run queued tasks until every task of the group has finished. Exceptions the tasks threw are kept for Group::Rethrow.
+	void Wait( Group& a_Group )
+	{
+		const size_t Index = GetIndex();
+
+		for ( ;; )
+		{
+			// Read the completion count first, so that a task finishing after the check below still wakes this thread.
+			const uint32_t Completed = m_Completed.load( std::memory_order_acquire );
+
+			if ( a_Group.IsDone() )
+			{
+				return;
+			}
+
+			if ( !TryRun( Index ) )
+			{
+				m_Completed.wait( Completed, std::memory_order_acquire );
+			}
+		}
+	}
+
+	// Split [ 0, a_Count ) into ranges of at least a_Grain and call a_Function( Begin, End ) on each, in parallel.
+	template < typename Function >
+	void ParallelFor( size_t a_Count, size_t a_Grain, Function&& a_Function )
+	{
+		const size_t Ranges = ( m_Threads.size() + 1u ) * 4u;
+		size_t Size = ( a_Count + Ranges - 1u ) / Ranges;
+		Size = Size < a_Grain ? a_Grain : Size;
+		Size = Size ? Size : 1u;
+
+		Group Ranged;
+
+		for ( size_t Begin = Size; Begin < a_Count; Begin += Size )
+		{
+			const size_t End = a_Count - Begin < Size ? a_Count : Begin + Size;
+			Spawn( Ranged, [ &a_Function, Begin, End ]() { a_Function( Begin, End ); } );
+		}
+
+		// The first range runs here, rather than queueing it only to steal it back. The ranges refer to the function and group,
+		// so they are waited for even if it throws.
+		try
+		{
+			a_Function( size_t( 0u ), a_Count < Size ? a_Count : Size );
+		}
+		catch ( ... )
+		{
+			Wait( Ranged );
+			throw;
+		}
+
+		Wait( Ranged );
+		Ranged.Rethrow();
+	}
+
+private:
+
+	struct Entry
+	{
+		Task   Function;
+		Group* Owner;
+	};
+
+	struct alignas( 64 ) Queue
+	{
+		std::mutex          Mutex;
+		std::deque< Entry > Tasks;
+	};
+
+	// The index of the calling thread's deque, or of the shared one for threads outside the pool.
+	size_t GetIndex() const
+	{
+		const Worker& Current = GetWorker();
+		return Current.Pool == this ? Current.Index : m_Threads.size();
+	}
+
+	void Work( size_t a_Index )
+	{
+		GetWorker() = { this, a_Index };
+
+		for ( ;; )
+		{
+			// Read the signal first, so that a task spawned after the search below still wakes this thread.
+			const uint32_t Signal = m_Signal.load( std::memory_order_acquire );
+
+			if ( m_Stop.load( std::memory_order_acquire ) )
+			{
+				return;
+			}
+
+			if ( !TryRun( a_Index ) )
+			{
+				m_Signal.wait( Signal, std::memory_order_acquire );
+			}
+		}
+	}
+
+	// Run the newest task of the thread's own deque, or else steal the oldest of another. Returns whether one was run.
+	bool TryRun( size_t a_Index )
+	{
+		Entry Next;
+		bool IsFound = false;
+
+		for ( size_t i = 0; i < m_Queues.size() && !IsFound; ++i )
+		{
+			Queue& Source = m_Queues[ ( a_Index + i ) % m_Queues.size() ];
+			std::lock_guard Lock( Source.Mutex );
+
+			if ( !Source.Tasks.empty() )
+			{
+				Next = std::move( i ? Source.Tasks.front() : Source.Tasks.back() );
+				i ? Source.Tasks.pop_front() : Source.Tasks.pop_back();
+				IsFound = true;
+			}
+		}
+
+		if ( !IsFound )
+		{
+			return false;
+		}
+
+		// An exception is kept for the group rather than let out, so that the task still counts as finished.
+		try
+		{
+			Next.Function();
+		}
+		catch ( ... )
+		{
+			if ( !Next.Owner->m_IsFailing.exchange( true, std::memory_order_relaxed ) )
+			{
+				Next.Owner->m_Error = std::current_exception();
+				Next.Owner->m_HasFailed.store( true, std::memory_order_release );
+			}
+		}
+
+		Next.Function = nullptr;
+
+		// The group may be destroyed as soon as it is done, so only the pool is touched after.
+		Next.Owner->m_Pending.fetch_sub( 1u, std::memory_order_acq_rel );
+		m_Completed.fetch_add( 1u, std::memory_order_release );
+		m_Completed.notify_all();
+		return true;
+	}
+
+	struct Worker
+	{
+		const TaskPool* Pool = nullptr;
+		size_t          Index = 0u;
+	};
+
+	// The pool and deque of the calling thread, if it is a pool thread.
+	static Worker& GetWorker()
+	{
+		static thread_local Worker Current;
+		return Current;
+	}
+
+	std::vector< Queue >       m_Queues;
+	std::vector< std::thread > m_Threads;
+	std::atomic< uint32_t >    m_Signal;
+	std::atomic< uint32_t >    m_Completed;
+	std::atomic< bool >        m_Stop;
+};
+
+// A segment writer whose stream may have subtrees spliced into it, each serialised by a task into a writer of its own.
+class TaskWriter : public ISegmentWriter
+{
+public:
+
+	// Smallest upper bound size of a subtree for it to be split off by default.
+	static constexpr size_t DefaultThreshold = 64u * 1024u;
+
+	static constexpr size_t DefaultSegmentSize = 1024u * 1024u;
+
+	TaskWriter( TaskPool& a_Pool, size_t a_Threshold = DefaultThreshold, size_t a_SegmentSize = DefaultSegmentSize )
+		: m_Root( new Shared{ a_Pool, {}, a_Threshold, a_SegmentSize } )
+		, m_Shared( m_Root.get() )
+		, m_NextSize( a_SegmentSize )
+		, m_IsOpen( false )
+	{}
+
+	// The tasks write into the writer, so it cannot go before they finish.
+	~TaskWriter()
+	{
+		if ( m_Root )
+		{
+			m_Shared->Pool.Wait( m_Shared->Group );
+		}
+	}
+
+	TaskWriter( const TaskWriter& ) = delete;
+	TaskWriter& operator=( const TaskWriter& ) = delete;
+
+	// Reads the spliced stream back in order.
+	class Reader : public ISegmentReader
+	{
+	public:
+
+		Reader( const TaskWriter& a_Writer )
+			: m_Index( 0u )
+		{
+			a_Writer.GetSegments( m_Segments );
+		}
+
+		std::span< const byte_t > GetNextSegment() override
+		{
+			return m_Index < m_Segments.size() ? m_Segments[ m_Index++ ] : std::span< const byte_t >();
+		}
+
+	private:
+
+		std::vector< std::span< const byte_t > > m_Segments;
+		size_t                                   m_Index;
+	};
+
+	// Append the pieces of the spliced stream to o_Segments, in order, such as for a vectored write. Valid once the Serialiser is flushed.
+	void GetSegments( std::vector< std::span< const byte_t > >& o_Segments ) const
+	{
+		size_t Offset = 0u;
+		auto Next = m_Splices.begin();
+
+		for ( const Segment& Part : m_Segments )
+		{
+			size_t Start = 0u;
+
+			for ( ; Next != m_Splices.end() && Next->Offset <= Offset + Part.Size; ++Next )
+			{
+				if ( Next->Offset - Offset > Start )
+				{
+					o_Segments.emplace_back( Part.Data.get() + Start, Next->Offset - Offset - Start );
+				}
+
+				Start = Next->Offset - Offset;
+				Next->Writer->GetSegments( o_Segments );
+			}
+
+			if ( Part.Size > Start )
+			{
+				o_Segments.emplace_back( Part.Data.get() + Start, Part.Size - Start );
+			}
+
+			Offset += Part.Size;
+		}
+
+		for ( ; Next != m_Splices.end(); ++Next )
+		{
+			Next->Writer->GetSegments( o_Segments );
+		}
+	}
+
+	// Get the size of the spliced stream. Valid once the Serialiser is flushed.
+	size_t GetSize() const
+	{
+		size_t Size = 0u;
+
+		for ( const Segment& Part : m_Segments )
+		{
+			Size += Part.Size;
+		}
+
+		for ( const Splice& Part : m_Splices )
+		{
+			Size += Part.Writer->GetSize();
+		}
+
+		return Size;
+	}
+
+	// Copy the spliced stream into a buffer of at least GetSize() bytes.
+	void CopyTo( byte_t* o_Data ) const
+	{
+		std::vector< std::span< const byte_t > > Segments;
+		GetSegments( Segments );
+
+		for ( const std::span< const byte_t > Part : Segments )
+		{
+			memcpy( o_Data, Part.data(), Part.size() );
+			o_Data += Part.size();
+		}
+	}
+
+	// Spawn a task serialising the object into a writer spliced in at a_Offset of this writer's stream, if its upper bound
+	// size is over the threshold. Returns false if the object is too small, for the caller to serialise in place. The object
+	// is read by the task, so it must outlive the Flush.
+	template < typename T >
+	bool Spawn( const T& a_Object, size_t a_Offset )
+	{
+		Sizer Bounder( Serialisation::Packed, Sizer::UpperBound );
+		const size_t Bound = Bounder + a_Object;
+
+		if ( Bound < m_Shared->Threshold )
+		{
+			return false;
+		}
+
+		// The first segment is sized to the subtree, so that small tasks do not each hold a whole segment.
+		const size_t Size = Bound < m_Shared->SegmentSize ? Bound : m_Shared->SegmentSize;
+		TaskWriter* Child = m_Splices.emplace_back( Splice{ a_Offset, std::unique_ptr< TaskWriter >( new TaskWriter( *m_Shared, Size ) ) } ).Writer.get();
+
+		m_Shared->Pool.Spawn( m_Shared->Group, [ Child, &a_Object ]()
+		{
+			Serialiser serialiser( *Child );
+			serialiser << a_Object;
+			serialiser.Flush();
+		} );
+
+		return true;
+	}
+
+private:
+
+	// State common to a writer and every writer spliced into it.
+	struct Shared
+	{
+		TaskPool&       Pool;
+		TaskPool::Group Group;
+		size_t          Threshold;
+		size_t          SegmentSize;
+	};
+
+	struct Segment
+	{
+		std::unique_ptr< byte_t[] > Data;
+		size_t                      Capacity;
+		size_t                      Size;
+	};
+
+	struct Splice
+	{
+		size_t                        Offset;
+		std::unique_ptr< TaskWriter > Writer;
+	};
+
+	TaskWriter( Shared& a_Shared, size_t a_FirstSize )
+		: m_Shared( &a_Shared )
+		, m_NextSize( a_FirstSize ? a_FirstSize : 1u )
+		, m_IsOpen( false )
+	{}
+
+	std::span< byte_t > GetNextSegment( size_t a_Used ) override
+	{
+		Close( a_Used );
+
+		m_Segments.push_back( { std::unique_ptr< byte_t[] >( new byte_t[ m_NextSize ] ), m_NextSize, 0u } );
+		m_NextSize = m_Shared->SegmentSize;
+		m_IsOpen = true;
+
+		return { m_Segments.back().Data.get(), m_Segments.back().Capacity };
+	}
+
+	// Close the last segment, and for the writer the Serialiser was given, wait for every task, rethrowing any exception.
+	void Commit( size_t a_Used ) override
+	{
+		Close( a_Used );
+
+		if ( m_Root )
+		{
+			m_Shared->Pool.Wait( m_Shared->Group );
+			m_Shared->Group.Rethrow();
+		}
+	}
+
+	void Close( size_t a_Used )
+	{
+		if ( m_IsOpen )
+		{
+			m_Segments.back().Size = a_Used;
+			m_IsOpen = false;
+		}
+	}
+
+	std::unique_ptr< Shared > m_Root;
+	Shared*                   m_Shared;
+	std::vector< Segment >    m_Segments;
+	std::vector< Splice >     m_Splices;
+	size_t                    m_NextSize;
+	bool                      m_IsOpen;
+};
+
+// Serialises a subtree as a task when written to a TaskWriter's Serialiser, and in place otherwise. Reading and sizing are
+// unchanged, since the stream is the same either way. The subtree is held by reference until the Flush, so it must not be a
+// local or temporary of the hook.
+template < typename T >
+class Parallel
+{
+public:
+
+	Parallel( T& a_Value )
+		: m_Value( a_Value )
+	{}
+
+	void OnSerialise( Serialiser& a_Serialiser ) const
+	{
+		auto* Writer = dynamic_cast< TaskWriter* >( a_Serialiser.GetSegmentWriter() );
+
+		if ( !Writer || a_Serialiser.GetAlignment() != Serialisation::Packed || !Writer->Spawn( m_Value, a_Serialiser.GetBytesWritten() ) )
+		{
+			a_Serialiser << m_Value;
+		}
+	}
+
+	void OnDeserialise( Deserialiser& a_Deserialiser ) const
+	{
+		a_Deserialiser >> m_Value;
+	}
+
+	void OnSize( Sizer& a_Sizer ) const
+	{
+		a_Sizer + m_Value;
+	}
+
+private:
+
+	T& m_Value;
+};
+
+template < typename T >
+inline Parallel< T > AsParallel( T& a_Value ) { return { a_Value }; }
@@ -0,0 +1,313 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <type_traits>
+#include <vector>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define SERIALISATION_TRACE_TSC 1
+#elif defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define SERIALISATION_TRACE_TSC 1
+#else
+#define SERIALISATION_TRACE_TSC 0
+#endif
+
+//==========================================================================
+// Optional trace points in the archives, enabled by defining
+// SERIALISATION_TRACE before including Serialisation.hpp. Every container and
+// every object with a serialisation hook records an event of its type, nesting
+// depth, byte count and tick range into a ring buffer owned by the calling
+// thread. Recording takes no locks, and the oldest events are overwritten once
+// a ring is full. When SERIALISATION_TRACE is not defined the trace points
+// expand to nothing.
+//
+// std::string Json = SerialisationTrace::DumpChromeTrace(); // Load in chrome://tracing or Perfetto.
+//==========================================================================
+namespace SerialisationTrace
+{
+// Number of events kept per thread. Must be a power of two.
+static constexpr size_t RingCapacity = 1u << 14u;
+
+enum class Phase : uint8_t
+{
+	Serialise,
+	Deserialise,
+};
+
+struct Event
+{
+	const std::type_info*     Type;
+	uint64_t                  Begin;
+	uint64_t                  End;
+	uint64_t                  Bytes;
+	uint32_t                  Depth;
+	SerialisationTrace::Phase Phase;
+};
+
+// Read the tick counter. The TSC where available, otherwise the steady clock.
+inline uint64_t Now()
+{
+#if SERIALISATION_TRACE_TSC
+	return __rdtsc();
+#else
+	return static_cast< uint64_t >( std::chrono::steady_clock::now().time_since_epoch().count() );
+#endif
+}
+
+// Events recorded by a single thread. Only the owning thread writes; the head is published so that a dump can read concurrently.
+struct Ring
+{
+	Event                   Events[ RingCapacity ];
+	std::atomic< uint64_t > Head = 0;
+	uint32_t                Depth = 0;
+	uint32_t                Thread = 0;
+	uint64_t                Retired = 0; // Order in which the owning thread exited, or 0 while it runs.
+	bool                    IsFree = false; // Retired and dumped or cleared, so free to be taken by a new thread.
+};
+
+// Owns the rings of every thread that has recorded, so that events outlive their thread until dumped. The ring of an exited
+// thread is taken by the next new thread once its events have been dumped or cleared, or, past MaxRetired undumped rings, as
+// the oldest of them, so the registry only grows with the number of threads running at once.
+struct Registry
+{
+	// Most rings of exited threads kept for a dump before the oldest is taken by a new thread.
+	static constexpr size_t MaxRetired = 64u;
+
+	std::mutex                            Mutex;
+	std::vector< std::unique_ptr< Ring > > Rings;
+	uint64_t                              Retired = 0;
+	uint32_t                              Threads = 0;
+	uint64_t                              EpochTicks = Now();
+	std::chrono::steady_clock::time_point EpochTime = std::chrono::steady_clock::now();
+
+	static Registry& Get()
+	{
+		static Registry Instance;
+		return Instance;
+	}
+
+	// Mark the retired rings free once their events have been read or discarded. Must be called under the mutex.
+	void FreeRetired()
+	{
+		for ( auto& Ring : Rings )
+		{
+			Ring->IsFree = Ring->Retired != 0;
+		}
+	}
+};
+
+// Retires the calling thread's ring when the thread exits.
+struct RingOwner
+{
+	Ring* Owned = nullptr;
+
+	~RingOwner()
+	{
+		if ( Owned )
+		{
+			Registry& State = Registry::Get();
+			std::lock_guard Lock( State.Mutex );
+			Owned->Retired = ++State.Retired;
+		}
+	}
+};
+
+// Get the calling thread's ring, registering it on first use.
+inline Ring& GetRing()
+{
+	static thread_local RingOwner Owner;
+
+	if ( !Owner.Owned )
+	{
+		Registry& State = Registry::Get();
+		std::lock_guard Lock( State.Mutex );
+		Ring* Taken = nullptr;
+		size_t RetiredCount = 0;
+
+		for ( auto& Candidate : State.Rings )
+		{
+			if ( Candidate->IsFree )
+			{
+				Taken = Candidate.get();
+				break;
+			}
+
+			if ( Candidate->Retired )
+			{
+				++RetiredCount;
+				Taken = !Taken || Candidate->Retired < Taken->Retired ? Candidate.get() : Taken;
+			}
+		}
+
+		if ( !Taken || ( !Taken->IsFree && RetiredCount < Registry::MaxRetired ) )
+		{
+			State.Rings.push_back( std::make_unique< Ring >() );
+			Taken = State.Rings.back().get();
+		}
+
+		Taken->Head.store( 0, std::memory_order_release );
+		Taken->Depth = 0;
+		Taken->Thread = ++State.Threads;
+		Taken->Retired = 0;
+		Taken->IsFree = false;
+		Owner.Owned = Taken;
+	}
+
+	return *Owner.Owned;
+}
+
+// Records an event spanning its lifetime. The byte count is the archive's progress over that span.
+template < typename T, typename Archive >
+class Scope
+{
+public:
+
+	Scope( const Archive& a_Archive )
+		: m_Archive( a_Archive )
+		, m_Ring( GetRing() )
+		, m_Position( GetPosition() )
+		, m_Begin( Now() )
+	{
+		++m_Ring.Depth;
+	}
+
+	~Scope()
+	{
+		const uint64_t End = Now();
+		const uint64_t Head = m_Ring.Head.load( std::memory_order_relaxed );
+		Event& Slot = m_Ring.Events[ Head & ( RingCapacity - 1u ) ];
+		Slot.Type = &typeid( T );
+		Slot.Begin = m_Begin;
+		Slot.End = End;
+		Slot.Bytes = GetPosition() - m_Position;
+		Slot.Depth = --m_Ring.Depth;
+		Slot.Phase = requires { m_Archive.GetBytesWritten(); } ? Phase::Serialise : Phase::Deserialise;
+		m_Ring.Head.store( Head + 1u, std::memory_order_release );
+	}
+
+	Scope( const Scope& ) = delete;
+	Scope& operator=( const Scope& ) = delete;
+
+private:
+
+	size_t GetPosition() const
+	{
+		if constexpr ( requires { m_Archive.GetBytesWritten(); } )
+		{
+			return m_Archive.GetBytesWritten();
+		}
+		else
+		{
+			return m_Archive.GetBytesRead();
+		}
+	}
+
+	const Archive& m_Archive;
+	Ring&          m_Ring;
+	size_t         m_Position;
+	uint64_t       m_Begin;
+};
+
+// Discard every recorded event. Must not race with recording threads.
+inline void Clear()
+{
+	Registry& State = Registry::Get();
+	std::lock_guard Lock( State.Mutex );
+
+	for ( auto& Ring : State.Rings )
+	{
+		Ring->Head.store( 0, std::memory_order_release );
+	}
+
+	State.FreeRetired();
+}
+
+// Write the recorded events of every thread as Chrome trace event JSON. Ticks are converted to microseconds against the
+// steady clock over the time since the first trace point. Events overwritten while the dump was running are dropped.
+inline std::string DumpChromeTrace()
+{
+	Registry& State = Registry::Get();
+	std::lock_guard Lock( State.Mutex );
+
+	const uint64_t Ticks = Now() - State.EpochTicks;
+	const double Microseconds = std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - State.EpochTime ).count();
+	const double TicksPerMicrosecond = Microseconds > 0.0 && Ticks ? Ticks / Microseconds : 1.0;
+
+	std::string Json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	std::vector< Event > Events;
+	bool First = true;
+
+	for ( auto& Ring : State.Rings )
+	{
+		const uint64_t Head = Ring->Head.load( std::memory_order_acquire );
+		const uint64_t Count = Head < RingCapacity ? Head : RingCapacity;
+		Events.resize( Count );
+
+		for ( uint64_t i = 0; i < Count; ++i )
+		{
+			Events[ i ] = Ring->Events[ ( Head - Count + i ) & ( RingCapacity - 1u ) ];
+		}
+
+		// Drop any event the owning thread may have overwritten while it was copied, including the slot it may be writing now.
+		const uint64_t Written = Ring->Head.load( std::memory_order_acquire ) + 1u;
+		const uint64_t Oldest = Written > RingCapacity && Written - RingCapacity > Head - Count ? Written - RingCapacity : Head - Count;
+
+		for ( uint64_t i = Oldest - ( Head - Count ); i < Count; ++i )
+		{
+			const Event& Recorded = Events[ i ];
+			const double Begin = static_cast< double >( Recorded.Begin - State.EpochTicks ) / TicksPerMicrosecond;
+			const double Duration = static_cast< double >( Recorded.End - Recorded.Begin ) / TicksPerMicrosecond;
+
+			Json += First ? "{\"name\":\"" : ",{\"name\":\"";
+			First = false;
+
+			for ( const char* Name = Recorded.Type->name(); *Name; ++Name )
+			{
+				if ( *Name == '"' || *Name == '\\' )
+				{
+					Json += '\\';
+				}
+
+				Json += *Name;
+			}
+
+			Json += Recorded.Phase == Phase::Serialise ? "\",\"cat\":\"Serialise\"" : "\",\"cat\":\"Deserialise\"";
+			Json += ",\"ph\":\"X\",\"pid\":0,\"tid\":" + std::to_string( Ring->Thread );
+			Json += ",\"ts\":" + std::to_string( Begin );
+			Json += ",\"dur\":" + std::to_string( Duration );
+			Json += ",\"args\":{\"bytes\":" + std::to_string( Recorded.Bytes );
+			Json += ",\"depth\":" + std::to_string( Recorded.Depth ) + "}}";
+		}
+	}
+
+	State.FreeRetired();
+	Json += "]}";
+	return Json;
+}
+
+// Stands in for a Scope on trace points whose condition does not hold.
+struct NoScope
+{
+	template < typename Archive >
+	NoScope( const Archive& ) {}
+};
+} // SerialisationTrace
+
+// Trace the serialisation of the object by the archive until the end of the enclosing block, optionally only if a constant condition holds.
+#ifdef SERIALISATION_TRACE
+#define SERIALISATION_TRACE_SCOPE( Archive, Object ) \
+	SerialisationTrace::Scope< std::remove_cvref_t< decltype( Object ) >, std::remove_cvref_t< decltype( Archive ) > > TraceScope( Archive )
+#define SERIALISATION_TRACE_SCOPE_IF( Condition, Archive, Object ) \
+	std::conditional_t< ( Condition ), SerialisationTrace::Scope< std::remove_cvref_t< decltype( Object ) >, std::remove_cvref_t< decltype( Archive ) > >, SerialisationTrace::NoScope > TraceScope( Archive )
+#else
+#define SERIALISATION_TRACE_SCOPE( Archive, Object )
+#define SERIALISATION_TRACE_SCOPE_IF( Condition, Archive, Object )
+#endif